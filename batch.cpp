@@ -0,0 +1,140 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "batch.h"
+
+static void appendEntry(std::vector<BatchEntry>& list, const char* input, const char* output, int key) {
+    BatchEntry entry;
+    entry.input_path = strdup(input);
+    entry.output_path = strdup(output);
+    entry.key = key;
+    list.push_back(entry);
+}
+
+static void publishEntries(std::vector<BatchEntry>& list, BatchEntry** entries, size_t* count) {
+    *count = list.size();
+    *entries = (BatchEntry*)malloc((list.size() > 0 ? list.size() : 1) * sizeof(BatchEntry));
+    if (!list.empty()) {
+        memcpy(*entries, list.data(), list.size() * sizeof(BatchEntry));
+    }
+}
+
+static void freeEntries(std::vector<BatchEntry>& list) {
+    for (BatchEntry& entry : list) {
+        free(entry.input_path);
+        free(entry.output_path);
+    }
+}
+
+int batchLoadManifest(const char* path, BatchEntry** entries, size_t* count, size_t* bad_line) {
+    *bad_line = 0;
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        return -1;
+    }
+    std::vector<BatchEntry> list;
+    char* line = nullptr;
+    size_t line_size = 0;
+    size_t line_number = 0;
+    int status = 0;
+    while (getline(&line, &line_size, file) != -1) {
+        ++line_number;
+        const char* separators = " \t\r\n";
+        char* save = nullptr;
+        char* input = strtok_r(line, separators, &save);
+        if (input == nullptr || input[0] == '#') {
+            continue;
+        }
+        char* output = strtok_r(nullptr, separators, &save);
+        char* key_text = strtok_r(nullptr, separators, &save);
+        char* end = nullptr;
+        long key = key_text != nullptr ? strtol(key_text, &end, 10) : 0;
+        if (output == nullptr || key_text == nullptr || *end != '\0' || strtok_r(nullptr, separators, &save) != nullptr) {
+            *bad_line = line_number;
+            status = -1;
+            break;
+        }
+        appendEntry(list, input, output, (int)key);
+    }
+    if (status == 0 && ferror(file)) {
+        status = -1;
+    }
+    free(line);
+    fclose(file);
+    if (status != 0) {
+        freeEntries(list);
+        return -1;
+    }
+    publishEntries(list, entries, count);
+    return 0;
+}
+
+// output_root (compared by device and inode, however it is spelled) is skipped
+// so an output tree nested inside the input is not scanned into itself.
+// Directory links are not followed, which also rules out cycles.
+static int scanDirectory(const std::string& input_dir, const std::string& output_dir, const struct stat& output_root,
+                         int key, std::vector<BatchEntry>& list) {
+    if (mkdir(output_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        return -1;
+    }
+    DIR* dir = opendir(input_dir.c_str());
+    if (dir == nullptr) {
+        return -1;
+    }
+    int status = 0;
+    struct dirent* item;
+    while (status == 0 && (item = readdir(dir)) != nullptr) {
+        if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0) {
+            continue;
+        }
+        std::string input = input_dir + "/" + item->d_name;
+        std::string output = output_dir + "/" + item->d_name;
+        struct stat info;
+        if (lstat(input.c_str(), &info) != 0) {
+            status = -1;
+        } else if (S_ISLNK(info.st_mode)) {
+            // Dangling links and links to anything but a file are skipped.
+            if (stat(input.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+                appendEntry(list, input.c_str(), output.c_str(), key);
+            }
+        } else if (S_ISDIR(info.st_mode)) {
+            if (info.st_dev != output_root.st_dev || info.st_ino != output_root.st_ino) {
+                status = scanDirectory(input, output, output_root, key, list);
+            }
+        } else if (S_ISREG(info.st_mode)) {
+            appendEntry(list, input.c_str(), output.c_str(), key);
+        }
+    }
+    int saved = errno;
+    closedir(dir);
+    errno = saved;
+    return status;
+}
+
+int batchScanDirectory(const char* input_dir, const char* output_dir, int key,
+                       BatchEntry** entries, size_t* count) {
+    std::vector<BatchEntry> list;
+    struct stat output_root;
+    if ((mkdir(output_dir, 0755) != 0 && errno != EEXIST) || stat(output_dir, &output_root) != 0
+        || scanDirectory(input_dir, output_dir, output_root, key, list) != 0) {
+        int saved = errno;
+        freeEntries(list);
+        errno = saved;
+        return -1;
+    }
+    publishEntries(list, entries, count);
+    return 0;
+}
+
+void batchFreeEntries(BatchEntry* entries, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        free(entries[i].input_path);
+        free(entries[i].output_path);
+    }
+    free(entries);
+}
@@ -0,0 +1,33 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+
+// Job lists for bulk encryption: the entries of a manifest or of a directory
+// tree. They are run with uringTransformFiles (uring_io.h), which already
+// keeps many files in flight and spreads the blocks of a large one over every
+// core.
+
+struct BatchEntry {
+    char* input_path;
+    char* output_path;
+    int key;
+};
+
+// Reads a manifest with one "input output key" entry per line, separated by
+// spaces or tabs. Blank lines and lines starting with '#' are skipped. Returns
+// 0, or -1 if the file cannot be read or a line is malformed (*bad_line then
+// holds its 1-based number, or 0 for an I/O error).
+int batchLoadManifest(const char* path, BatchEntry** entries, size_t* count, size_t* bad_line);
+
+// Collects every regular file under input_dir, mirroring the tree under
+// output_dir (directories are created as needed) with the same key for all.
+// Symbolic links to files are followed, links to directories are not, and
+// output_dir itself is skipped if it lies inside input_dir. Returns 0 or -1
+// with errno set.
+int batchScanDirectory(const char* input_dir, const char* output_dir, int key,
+                       BatchEntry** entries, size_t* count);
+
+void batchFreeEntries(BatchEntry* entries, size_t count);
+
+#endif // BATCH_H
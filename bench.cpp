@@ -0,0 +1,464 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "caesar.h"
+#include "text_editor.h"
+
+// Micro-benchmarks for the cipher and editor hot paths. The command line and
+// the JSON report follow Google Benchmark (--benchmark_filter,
+// --benchmark_min_time, --benchmark_out), so results can be compared with the
+// usual tooling between releases.
+
+// CPU time of every thread in the process, so parallel kernels are charged for
+// all the cores they keep busy.
+static double processCpuSeconds() {
+    timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+class BenchState {
+private:
+    long long iterations;
+    long long remaining;
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point finished;
+    double cpu_started;
+    double cpu_finished;
+    double paused_seconds;
+    double paused_cpu_seconds;
+    std::chrono::steady_clock::time_point pause_started;
+    double pause_cpu_started;
+
+public:
+    long long bytes_processed;
+
+    explicit BenchState(long long iterations_to_run) {
+        iterations = iterations_to_run;
+        remaining = iterations_to_run;
+        cpu_started = 0.0;
+        cpu_finished = 0.0;
+        paused_seconds = 0.0;
+        paused_cpu_seconds = 0.0;
+        pause_cpu_started = 0.0;
+        bytes_processed = 0;
+    }
+
+    // Usage: while (state.keepRunning()) { ...measured body... }
+    // The clock stops when the last iteration ends, so whatever the benchmark
+    // tears down after its loop is not measured.
+    bool keepRunning() {
+        if (remaining == iterations) {
+            cpu_started = processCpuSeconds();
+            started = std::chrono::steady_clock::now();
+        }
+        if (remaining == 0) {
+            finished = std::chrono::steady_clock::now();
+            cpu_finished = processCpuSeconds();
+            return false;
+        }
+        remaining--;
+        return true;
+    }
+
+    void pauseTiming() {
+        pause_cpu_started = processCpuSeconds();
+        pause_started = std::chrono::steady_clock::now();
+    }
+
+    void resumeTiming() {
+        paused_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - pause_started).count();
+        paused_cpu_seconds += processCpuSeconds() - pause_cpu_started;
+    }
+
+    long long getIterations() const {
+        return iterations;
+    }
+
+    double elapsedSeconds() const {
+        double total = std::chrono::duration<double>(finished - started).count();
+        return total - paused_seconds;
+    }
+
+    double cpuSeconds() const {
+        return cpu_finished - cpu_started - paused_cpu_seconds;
+    }
+};
+
+typedef void (*BenchFunc)(BenchState&, long long arg0, long long arg1);
+
+struct Benchmark {
+    std::string name;
+    BenchFunc func;
+    long long arg0;
+    long long arg1;
+};
+
+struct BenchResult {
+    std::string name;
+    long long iterations;
+    double ns_per_iteration;
+    double cpu_ns_per_iteration;
+    double bytes_per_second;
+};
+
+// Silences the editor's console chatter while it is being measured.
+class StdoutMute {
+private:
+    int saved_fd;
+
+public:
+    StdoutMute() {
+        fflush(stdout);
+        saved_fd = dup(STDOUT_FILENO);
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        close(null_fd);
+    }
+
+    ~StdoutMute() {
+        fflush(stdout);
+        dup2(saved_fd, STDOUT_FILENO);
+        close(saved_fd);
+    }
+};
+
+// ---- input generation ----
+
+// Fills `length` bytes where roughly alpha_percent of them are letters and the
+// rest are digits, spaces and punctuation.
+static void fillText(char* data, size_t length, int alpha_percent) {
+    static const char other[] = "0123456789 .,;:!?-()[]{}";
+    unsigned int seed = 12345;
+    for (size_t i = 0; i < length; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned int r = seed >> 8;
+        if ((int)(r % 100) < alpha_percent) {
+            data[i] = (char)(((r >> 8) & 1 ? 'a' : 'A') + (r >> 9) % 26);
+        } else {
+            data[i] = other[(r >> 9) % (sizeof(other) - 1)];
+        }
+    }
+}
+
+static void fillEditor(TextEditor& editor, int lines, int line_length) {
+    std::vector<char> line(line_length + 1);
+    fillText(line.data(), line_length, 80);
+    line[line_length] = '\0';
+    editor.init();
+    for (int i = 0; i < lines; i++) {
+        editor.appendText(line.data());
+    }
+}
+
+// ---- cipher ----
+
+static void benchEncrypt(BenchState& state, long long size, long long alpha_percent) {
+    std::vector<char> src(size), dst(size);
+    fillText(src.data(), size, (int)alpha_percent);
+    while (state.keepRunning()) {
+        encryptBuffer(src.data(), dst.data(), size, 7);
+    }
+    state.bytes_processed = state.getIterations() * size;
+}
+
+static void benchDecrypt(BenchState& state, long long size, long long alpha_percent) {
+    std::vector<char> src(size), dst(size);
+    fillText(src.data(), size, (int)alpha_percent);
+    while (state.keepRunning()) {
+        decryptBuffer(src.data(), dst.data(), size, 7);
+    }
+    state.bytes_processed = state.getIterations() * size;
+}
+
+// The original allocating, NUL-terminated entry point, for comparison.
+static void benchEncryptAlloc(BenchState& state, long long size, long long alpha_percent) {
+    std::vector<char> src(size + 1);
+    fillText(src.data(), size, (int)alpha_percent);
+    src[size] = '\0';
+    while (state.keepRunning()) {
+        delete[] encrypt(src.data(), 7);
+    }
+    state.bytes_processed = state.getIterations() * size;
+}
+
+// ---- TextContainer ----
+
+static void benchContainerAppend(BenchState& state, long long piece, long long) {
+    std::vector<char> text(piece + 1);
+    fillText(text.data(), piece, 80);
+    text[piece] = '\0';
+    TextContainer* container = new TextContainer();
+    long long appended = 0;
+    while (state.keepRunning()) {
+        container->append(text.data());
+        if (++appended % 1024 == 0) {
+            state.pauseTiming();
+            delete container;
+            container = new TextContainer();
+            state.resumeTiming();
+        }
+    }
+    delete container;
+    state.bytes_processed = state.getIterations() * piece;
+}
+
+static void benchContainerInsert(BenchState& state, long long line_length, long long) {
+    std::vector<char> line(line_length + 1);
+    fillText(line.data(), line_length, 80);
+    line[line_length] = '\0';
+    TextContainer container;
+    container.append(line.data());
+    while (state.keepRunning()) {
+        container.insert(container.getCurrentSize() / 2, "abcd");
+        state.pauseTiming();
+        container.deleteText(container.getCurrentSize() / 2, 4);
+        state.resumeTiming();
+    }
+}
+
+static void benchContainerDelete(BenchState& state, long long line_length, long long) {
+    std::vector<char> line(line_length + 1);
+    fillText(line.data(), line_length, 80);
+    line[line_length] = '\0';
+    TextContainer container;
+    container.append(line.data());
+    while (state.keepRunning()) {
+        container.deleteText(container.getCurrentSize() / 2, 4);
+        state.pauseTiming();
+        container.insert(container.getCurrentSize() / 2, "abcd");
+        state.resumeTiming();
+    }
+}
+
+// ---- TextEditor ----
+
+static void benchSearchWord(BenchState& state, long long lines, long long line_length) {
+    StdoutMute mute;
+    TextEditor editor;
+    fillEditor(editor, (int)lines, (int)line_length);
+    char word[] = "needle";
+    while (state.keepRunning()) {
+        editor.search_word(word);
+    }
+    state.bytes_processed = state.getIterations() * lines * line_length;
+}
+
+// Every edit snapshots the whole document onto the undo stack first.
+static void benchUndoSnapshot(BenchState& state, long long lines, long long line_length) {
+    StdoutMute mute;
+    TextEditor* editor = new TextEditor();
+    fillEditor(*editor, (int)lines, (int)line_length);
+    long long edits = 0;
+    while (state.keepRunning()) {
+        editor->insertText(0, 0, "x");
+        if (++edits % 256 == 0) {
+            state.pauseTiming();
+            delete editor;
+            editor = new TextEditor();
+            fillEditor(*editor, (int)lines, (int)line_length);
+            state.resumeTiming();
+        }
+    }
+    delete editor;
+}
+
+static std::string benchFilePath() {
+    return "/tmp/paradigms_bench_" + std::to_string((long long)getpid()) + ".txt";
+}
+
+static void benchSaveToFile(BenchState& state, long long lines, long long line_length) {
+    StdoutMute mute;
+    TextEditor editor;
+    fillEditor(editor, (int)lines, (int)line_length);
+    std::string path = benchFilePath();
+    while (state.keepRunning()) {
+        editor.saveToFile(path.c_str());
+    }
+    unlink(path.c_str());
+    state.bytes_processed = state.getIterations() * lines * (line_length + 1);
+}
+
+static void benchLoadFromFile(BenchState& state, long long lines, long long line_length) {
+    StdoutMute mute;
+    std::string path = benchFilePath();
+    {
+        TextEditor writer;
+        fillEditor(writer, (int)lines, (int)line_length);
+        writer.saveToFile(path.c_str());
+    }
+    TextEditor editor;
+    editor.init();
+    while (state.keepRunning()) {
+        editor.loadFromFile(path.c_str());
+    }
+    unlink(path.c_str());
+    state.bytes_processed = state.getIterations() * lines * (line_length + 1);
+}
+
+// ---- registry and runner ----
+
+static std::vector<Benchmark> registerBenchmarks(long long max_size) {
+    std::vector<Benchmark> benchmarks;
+    static const int densities[] = {0, 50, 100};
+
+    std::vector<long long> sizes;
+    for (long long size = 16; size <= max_size; size *= 16) {
+        sizes.push_back(size);
+    }
+    if (max_size >= (1LL << 30)) {
+        sizes.push_back(1LL << 30);
+    }
+
+    for (long long size : sizes) {
+        for (int density : densities) {
+            std::string suffix = "/" + std::to_string(size) + "/" + std::to_string(density);
+            benchmarks.push_back({"BM_encrypt" + suffix, benchEncrypt, size, density});
+            benchmarks.push_back({"BM_decrypt" + suffix, benchDecrypt, size, density});
+        }
+        if (size <= (1 << 20)) {
+            benchmarks.push_back({"BM_encrypt_alloc/" + std::to_string(size) + "/50", benchEncryptAlloc, size, 50});
+        }
+    }
+
+    for (long long piece : {8LL, 64LL, 512LL}) {
+        benchmarks.push_back({"BM_TextContainer_append/" + std::to_string(piece), benchContainerAppend, piece, 0});
+    }
+    for (long long length : {64LL, 4096LL, 262144LL}) {
+        benchmarks.push_back({"BM_TextContainer_insert/" + std::to_string(length), benchContainerInsert, length, 0});
+        benchmarks.push_back({"BM_TextContainer_deleteText/" + std::to_string(length), benchContainerDelete, length, 0});
+    }
+
+    for (long long lines : {100LL, 1000LL}) {
+        for (long long length : {16LL, 80LL}) {
+            std::string suffix = "/" + std::to_string(lines) + "/" + std::to_string(length);
+            benchmarks.push_back({"BM_TextEditor_search_word" + suffix, benchSearchWord, lines, length});
+            benchmarks.push_back({"BM_TextEditor_undo_snapshot" + suffix, benchUndoSnapshot, lines, length});
+            benchmarks.push_back({"BM_TextEditor_saveToFile" + suffix, benchSaveToFile, lines, length});
+            benchmarks.push_back({"BM_TextEditor_loadFromFile" + suffix, benchLoadFromFile, lines, length});
+        }
+    }
+    return benchmarks;
+}
+
+// Doubles the iteration count until one run lasts at least min_time.
+static BenchResult runBenchmark(const Benchmark& benchmark, double min_time) {
+    long long iterations = 1;
+    while (true) {
+        BenchState state(iterations);
+        benchmark.func(state, benchmark.arg0, benchmark.arg1);
+        double seconds = state.elapsedSeconds();
+        if (seconds >= min_time || iterations >= (1LL << 40)) {
+            BenchResult result;
+            result.name = benchmark.name;
+            result.iterations = iterations;
+            result.ns_per_iteration = seconds * 1e9 / (double)iterations;
+            result.cpu_ns_per_iteration = state.cpuSeconds() * 1e9 / (double)iterations;
+            result.bytes_per_second = seconds > 0.0 ? (double)state.bytes_processed / seconds : 0.0;
+            return result;
+        }
+        long long next = seconds > 0.0 ? (long long)(iterations * 1.4 * min_time / seconds) : iterations * 10;
+        iterations = next > iterations * 10 ? iterations * 10 : (next > iterations ? next : iterations * 2);
+    }
+}
+
+static void writeJson(FILE* out, const std::vector<BenchResult>& results) {
+    char date[64];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    fprintf(out, "{\n  \"context\": {\n");
+    fprintf(out, "    \"date\": \"%s\",\n", date);
+    fprintf(out, "    \"executable\": \"bench\",\n");
+    fprintf(out, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+    fprintf(out, "    \"library_build_type\": \"release\"\n");
+#else
+    fprintf(out, "    \"library_build_type\": \"debug\"\n");
+#endif
+    fprintf(out, "  },\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        fprintf(out, "    {\n");
+        fprintf(out, "      \"name\": \"%s\",\n", r.name.c_str());
+        fprintf(out, "      \"run_name\": \"%s\",\n", r.name.c_str());
+        fprintf(out, "      \"run_type\": \"iteration\",\n");
+        fprintf(out, "      \"iterations\": %lld,\n", r.iterations);
+        fprintf(out, "      \"real_time\": %.3f,\n", r.ns_per_iteration);
+        fprintf(out, "      \"cpu_time\": %.3f,\n", r.cpu_ns_per_iteration);
+        fprintf(out, "      \"time_unit\": \"ns\"");
+        if (r.bytes_per_second > 0.0) {
+            fprintf(out, ",\n      \"bytes_per_second\": %.1f", r.bytes_per_second);
+        }
+        fprintf(out, "\n    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+static void printUsage() {
+    printf("Usage: bench [--benchmark_filter=<substring>] [--benchmark_min_time=<seconds>]\n");
+    printf("             [--benchmark_out=<file.json>] [--max_size=<bytes>] [--benchmark_list_tests]\n");
+}
+
+int main(int argc, char** argv) {
+    const char* filter = "";
+    const char* out_path = nullptr;
+    double min_time = 0.5;
+    long long max_size = 1LL << 30;
+    bool list_only = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--benchmark_filter=", 19) == 0) {
+            filter = argv[i] + 19;
+        } else if (strncmp(argv[i], "--benchmark_min_time=", 21) == 0) {
+            min_time = atof(argv[i] + 21);
+        } else if (strncmp(argv[i], "--benchmark_out=", 16) == 0) {
+            out_path = argv[i] + 16;
+        } else if (strncmp(argv[i], "--max_size=", 11) == 0) {
+            max_size = atoll(argv[i] + 11);
+        } else if (strcmp(argv[i], "--benchmark_list_tests") == 0) {
+            list_only = true;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    printf("%-48s %14s %12s %14s\n", "Benchmark", "Time (ns)", "Iterations", "Throughput");
+    for (const Benchmark& benchmark : registerBenchmarks(max_size)) {
+        if (strstr(benchmark.name.c_str(), filter) == nullptr) {
+            continue;
+        }
+        if (list_only) {
+            printf("%s\n", benchmark.name.c_str());
+            continue;
+        }
+        BenchResult result = runBenchmark(benchmark, min_time);
+        printf("%-48s %14.1f %12lld", result.name.c_str(), result.ns_per_iteration, result.iterations);
+        if (result.bytes_per_second > 0.0) {
+            printf(" %10.1f MB/s", result.bytes_per_second / 1e6);
+        }
+        printf("\n");
+        fflush(stdout);
+        results.push_back(result);
+    }
+
+    if (out_path != nullptr && !list_only) {
+        FILE* out = fopen(out_path, "w");
+        if (out == nullptr) {
+            fprintf(stderr, "Unable to open %s for writing.\n", out_path);
+            return 1;
+        }
+        writeJson(out, results);
+        fclose(out);
+    }
+    return 0;
+}
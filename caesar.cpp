@@ -1,49 +1,539 @@
+
 #include <iostream>
 #include <cstring>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "caesar.h"
+#include "cipher_plugin.h"
+#include "io_util.h"
 
-    char* encrypt(const char* rawText, int key) {
-        int length = strlen(rawText);
-        char* encryptedText = new char[length + 1];
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CAESAR_X86 1
+#endif
 
-        key = key % 26;
+// Shift amounts are always normalized into [0, 26) before they reach a kernel,
+// so decryption is just encryption with the complementary shift.
+static int normalizeShift(int key) {
+    return ((key % 26) + 26) % 26;
+}
 
-        for (int i = 0; i < length; ++i) {
-            char ch = rawText[i];
+// One 256-entry byte translation table per shift, generated at compile time.
+// Non-letters map to themselves, so a lookup needs no range checks or modulo.
+struct ShiftTables {
+    unsigned char map[26][256];
+};
 
+static constexpr ShiftTables buildShiftTables() {
+    ShiftTables tables{};
+    for (int shift = 0; shift < 26; ++shift) {
+        for (int ch = 0; ch < 256; ++ch) {
+            int mapped = ch;
             if (ch >= 'A' && ch <= 'Z') {
-                encryptedText[i] = 'A' + (ch - 'A' + key) % 26;
+                mapped = 'A' + (ch - 'A' + shift) % 26;
             }
             else if (ch >= 'a' && ch <= 'z') {
-                encryptedText[i] = 'a' + (ch - 'a' + key) % 26;
+                mapped = 'a' + (ch - 'a' + shift) % 26;
+            }
+            tables.map[shift][ch] = (unsigned char)mapped;
+        }
+    }
+    return tables;
+}
+
+static constexpr ShiftTables shiftTables = buildShiftTables();
+
+static_assert(shiftTables.map[3]['x'] == 'a', "shift table wraps lowercase");
+static_assert(shiftTables.map[25]['B'] == 'A', "shift table wraps uppercase");
+static_assert(shiftTables.map[7]['!'] == '!', "shift table keeps non-letters");
+
+static void shiftScalar(const char* src, char* dst, size_t length, int shift) {
+    const unsigned char* table = shiftTables.map[shift];
+    const unsigned char* in = (const unsigned char*)src;
+    unsigned char* out = (unsigned char*)dst;
+
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        unsigned char a = table[in[i]];
+        unsigned char b = table[in[i + 1]];
+        unsigned char c = table[in[i + 2]];
+        unsigned char d = table[in[i + 3]];
+        out[i] = a;
+        out[i + 1] = b;
+        out[i + 2] = c;
+        out[i + 3] = d;
+    }
+    for (; i < length; ++i) {
+        out[i] = table[in[i]];
+    }
+}
+
+#ifdef CAESAR_X86
+// Both vector kernels use the same trick: folding to lowercase with |0x20 makes
+// one range check cover both cases, and the wrap-around is a second compare
+// that subtracts 26 from the shift only for letters that run past 'z'.
+__attribute__((target("sse2")))
+static void shiftSse2(const char* src, char* dst, size_t length, int shift) {
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i lowerA = _mm_set1_epi8('a');
+    const __m128i bias = _mm_set1_epi8((char)0x80);
+    const __m128i alphaLimit = _mm_set1_epi8((char)(-128 + 26));
+    const __m128i wrapLimit = _mm_set1_epi8((char)(25 - shift));
+    const __m128i shiftVec = _mm_set1_epi8((char)shift);
+    const __m128i wrapVec = _mm_set1_epi8(26);
+
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i offset = _mm_sub_epi8(_mm_or_si128(x, caseBit), lowerA);
+        __m128i alpha = _mm_cmpgt_epi8(alphaLimit, _mm_xor_si128(offset, bias));
+        __m128i wrap = _mm_cmpgt_epi8(offset, wrapLimit);
+        __m128i delta = _mm_sub_epi8(shiftVec, _mm_and_si128(wrap, wrapVec));
+        x = _mm_add_epi8(x, _mm_and_si128(alpha, delta));
+        _mm_storeu_si128((__m128i*)(dst + i), x);
+    }
+    shiftScalar(src + i, dst + i, length - i, shift);
+}
+
+__attribute__((target("avx2")))
+static void shiftAvx2(const char* src, char* dst, size_t length, int shift) {
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i lowerA = _mm256_set1_epi8('a');
+    const __m256i bias = _mm256_set1_epi8((char)0x80);
+    const __m256i alphaLimit = _mm256_set1_epi8((char)(-128 + 26));
+    const __m256i wrapLimit = _mm256_set1_epi8((char)(25 - shift));
+    const __m256i shiftVec = _mm256_set1_epi8((char)shift);
+    const __m256i wrapVec = _mm256_set1_epi8(26);
+
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i offset = _mm256_sub_epi8(_mm256_or_si256(x, caseBit), lowerA);
+        __m256i alpha = _mm256_cmpgt_epi8(alphaLimit, _mm256_xor_si256(offset, bias));
+        __m256i wrap = _mm256_cmpgt_epi8(offset, wrapLimit);
+        __m256i delta = _mm256_sub_epi8(shiftVec, _mm256_and_si256(wrap, wrapVec));
+        x = _mm256_add_epi8(x, _mm256_and_si256(alpha, delta));
+        _mm256_storeu_si256((__m256i*)(dst + i), x);
+    }
+    // Leave the 256-bit state clean before handing the tail to non-VEX code;
+    // skipping this costs a state transition on every short call.
+    _mm256_zeroupper();
+    shiftSse2(src + i, dst + i, length - i, shift);
+}
+#endif
+
+typedef void (*ShiftKernel)(const char*, char*, size_t, int);
+
+static ShiftKernel selectKernel() {
+#ifdef CAESAR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return shiftAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return shiftSse2;
+    }
+#endif
+    return shiftScalar;
+}
+
+// Resolved once when the library is loaded, so every host picks the widest
+// kernel its CPU supports without a per-call feature check.
+static const ShiftKernel shiftKernel = selectKernel();
+
+// CRC32C (Castagnoli, reflected polynomial 0x82F63B78). SSE4.2 computes it
+// eight bytes per instruction; other hosts use a compile-time byte table.
+struct Crc32cTable {
+    uint32_t entry[256];
+};
+
+static constexpr Crc32cTable buildCrc32cTable() {
+    Crc32cTable table{};
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+        uint32_t crc = byte;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0u);
+        }
+        table.entry[byte] = crc;
+    }
+    return table;
+}
+
+static constexpr Crc32cTable crc32cTable = buildCrc32cTable();
+
+static uint32_t crc32cScalar(uint32_t crc, const char* data, size_t length) {
+    const unsigned char* in = (const unsigned char*)data;
+    for (size_t i = 0; i < length; ++i) {
+        crc = crc32cTable.entry[(crc ^ in[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef CAESAR_X86
+__attribute__((target("sse4.2")))
+static uint32_t crc32cHardware(uint32_t crc, const char* data, size_t length) {
+    size_t i = 0;
+#ifdef __x86_64__
+    uint64_t crc64 = crc;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = (uint32_t)crc64;
+#endif
+    for (; i + 4 <= length; i += 4) {
+        uint32_t word;
+        memcpy(&word, data + i, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+    for (; i < length; ++i) {
+        crc = _mm_crc32_u8(crc, (unsigned char)data[i]);
+    }
+    return crc;
+}
+#endif
+
+typedef uint32_t (*Crc32cKernel)(uint32_t, const char*, size_t);
+
+static Crc32cKernel selectCrc32cKernel() {
+#ifdef CAESAR_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        return crc32cHardware;
+    }
+#endif
+    return crc32cScalar;
+}
+
+static const Crc32cKernel crc32cKernel = selectCrc32cKernel();
+
+// Shift and checksum are interleaved per block small enough to stay in L1, so
+// the CRC reads bytes the shift has just touched instead of making a second
+// trip through memory.
+#define CRC_FUSE_BLOCK (8 * 1024)
+
+static uint32_t kernelSimdLevel() {
+#ifdef CAESAR_X86
+    if (shiftKernel == shiftAvx2) {
+        return CIPHER_SIMD_AVX2;
+    }
+    if (shiftKernel == shiftSse2) {
+        return CIPHER_SIMD_SSE2;
+    }
+#endif
+    return CIPHER_SIMD_SCALAR;
+}
+
+void encryptBuffer(const char* src, char* dst, size_t length, int key) {
+    shiftKernel(src, dst, length, normalizeShift(key));
+}
+
+void decryptBuffer(const char* src, char* dst, size_t length, int key) {
+    shiftKernel(src, dst, length, normalizeShift(-key));
+}
+
+void encryptInPlace(char* text, size_t length, int key) {
+    shiftKernel(text, text, length, normalizeShift(key));
+}
+
+void decryptInPlace(char* text, size_t length, int key) {
+    shiftKernel(text, text, length, normalizeShift(-key));
+}
+
+void rekeyBuffer(const char* src, char* dst, size_t length, int old_key, int new_key) {
+    shiftKernel(src, dst, length, normalizeShift(new_key - old_key));
+}
+
+uint32_t caesarCrc32c(const char* data, size_t length) {
+    return ~crc32cKernel(~0u, data, length);
+}
+
+uint32_t encryptBufferCrc32c(const char* src, char* dst, size_t length, int key) {
+    int shift = normalizeShift(key);
+    uint32_t crc = ~0u;
+    for (size_t offset = 0; offset < length; offset += CRC_FUSE_BLOCK) {
+        size_t count = length - offset < CRC_FUSE_BLOCK ? length - offset : CRC_FUSE_BLOCK;
+        shiftKernel(src + offset, dst + offset, count, shift);
+        crc = crc32cKernel(crc, dst + offset, count);
+    }
+    return ~crc;
+}
+
+uint32_t decryptBufferCrc32c(const char* src, char* dst, size_t length, int key) {
+    int shift = normalizeShift(-key);
+    uint32_t crc = ~0u;
+    for (size_t offset = 0; offset < length; offset += CRC_FUSE_BLOCK) {
+        size_t count = length - offset < CRC_FUSE_BLOCK ? length - offset : CRC_FUSE_BLOCK;
+        crc = crc32cKernel(crc, src + offset, count);
+        shiftKernel(src + offset, dst + offset, count, shift);
+    }
+    return ~crc;
+}
+
+static void shiftParallel(const char* src, char* dst, size_t length, int shift, unsigned threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    size_t chunks = (length + CAESAR_PARALLEL_CHUNK - 1) / CAESAR_PARALLEL_CHUNK;
+    if (threads > chunks) {
+        threads = (unsigned)chunks;
+    }
+    if (length < CAESAR_PARALLEL_THRESHOLD || threads <= 1) {
+        shiftKernel(src, dst, length, shift);
+        return;
+    }
+
+    // Workers claim chunks from a shared counter, so a slow core simply ends up
+    // doing fewer of them.
+    std::atomic<size_t> next_chunk(0);
+    auto worker = [&]() {
+        size_t chunk;
+        while ((chunk = next_chunk.fetch_add(1)) < chunks) {
+            size_t offset = chunk * CAESAR_PARALLEL_CHUNK;
+            size_t count = length - offset < CAESAR_PARALLEL_CHUNK ? length - offset : CAESAR_PARALLEL_CHUNK;
+            shiftKernel(src + offset, dst + offset, count, shift);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& t : pool) {
+        t.join();
+    }
+}
+
+void encryptParallel(const char* src, char* dst, size_t length, int key, unsigned threads) {
+    shiftParallel(src, dst, length, normalizeShift(key), threads);
+}
+
+void decryptParallel(const char* src, char* dst, size_t length, int key, unsigned threads) {
+    shiftParallel(src, dst, length, normalizeShift(-key), threads);
+}
+
+// Spans shorter than this are staged; longer ones already fill the vector loop.
+#define BATCH_GATHER_LIMIT 256
+#define BATCH_STAGING_SIZE (16 * 1024)
+
+static void shiftBatch(const CaesarSpan* spans, size_t count, int shift) {
+    char staging[BATCH_STAGING_SIZE];
+    size_t staged = 0;
+    size_t first_pending = 0;
+
+    auto flush = [&](size_t end) {
+        shiftKernel(staging, staging, staged, shift);
+        size_t offset = 0;
+        for (size_t j = first_pending; j < end; ++j) {
+            if (spans[j].length < BATCH_GATHER_LIMIT) {
+                memcpy(spans[j].dst, staging + offset, spans[j].length);
+                offset += spans[j].length;
             }
-            else {
-                encryptedText[i] = ch;
+        }
+        staged = 0;
+        first_pending = end;
+    };
+
+    for (size_t i = 0; i < count; ++i) {
+        const CaesarSpan& span = spans[i];
+        if (span.length >= BATCH_GATHER_LIMIT) {
+            shiftKernel(span.src, span.dst, span.length, shift);
+            continue;
+        }
+        if (staged + span.length > BATCH_STAGING_SIZE) {
+            flush(i);
+        }
+        memcpy(staging + staged, span.src, span.length);
+        staged += span.length;
+    }
+    flush(count);
+}
+
+void encryptBatch(const CaesarSpan* spans, size_t count, int key) {
+    shiftBatch(spans, count, normalizeShift(key));
+}
+
+void decryptBatch(const CaesarSpan* spans, size_t count, int key) {
+    shiftBatch(spans, count, normalizeShift(-key));
+}
+
+void caesarStreamInit(CaesarStream* stream, int key, bool decrypting) {
+    stream->shift = normalizeShift(decrypting ? -key : key);
+    stream->bytes_processed = 0;
+}
+
+void caesarStreamInitRekey(CaesarStream* stream, int old_key, int new_key) {
+    stream->shift = normalizeShift(new_key - old_key);
+    stream->bytes_processed = 0;
+}
+
+size_t caesarStreamUpdate(CaesarStream* stream, const char* in, size_t in_length, char* out, size_t out_capacity) {
+    size_t count = in_length < out_capacity ? in_length : out_capacity;
+    shiftKernel(in, out, count, stream->shift);
+    stream->bytes_processed += count;
+    return count;
+}
+
+long long caesarStreamPipe(CaesarStream* stream, int in_fd, int out_fd) {
+    char buffer[CAESAR_STREAM_BUFFER];
+    long long total = 0;
+    while (true) {
+        ssize_t got = read(in_fd, buffer, sizeof(buffer));
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            return -1;
         }
-        encryptedText[length] = '\0';
+        if (got == 0) {
+            return total;
+        }
+        caesarStreamUpdate(stream, buffer, (size_t)got, buffer, sizeof(buffer));
+        if (!writeAll(out_fd, buffer, (size_t)got)) {
+            return -1;
+        }
+        total += got;
+    }
+}
 
-        return encryptedText;
+// Relative letter frequencies of English text, 'a' through 'z'.
+static const double englishFrequency[26] = {
+    0.08167, 0.01492, 0.02782, 0.04253, 0.12702, 0.02228, 0.02015,
+    0.06094, 0.06966, 0.00153, 0.00772, 0.04025, 0.02406, 0.06749,
+    0.07507, 0.01929, 0.00095, 0.05987, 0.06327, 0.09056, 0.02758,
+    0.00978, 0.02360, 0.00150, 0.01974, 0.00074
+};
+
+// Largest block counted before the 32-bit bins are folded into the caller's
+// 64-bit totals; each of the four bins sees at most a quarter of it.
+#define HISTOGRAM_BLOCK (1u << 30)
+
+void caesarLetterHistogram(const char* text, size_t length, unsigned long long counts[26]) {
+    const unsigned char* in = (const unsigned char*)text;
+    while (length > 0) {
+        size_t block = length < HISTOGRAM_BLOCK ? length : HISTOGRAM_BLOCK;
+
+        // Four independent sets of counters, so runs of the same letter do not
+        // serialize on one store-to-load dependency.
+        unsigned int bins[4][256] = {};
+        size_t i = 0;
+        for (; i + 4 <= block; i += 4) {
+            bins[0][in[i]]++;
+            bins[1][in[i + 1]]++;
+            bins[2][in[i + 2]]++;
+            bins[3][in[i + 3]]++;
+        }
+        for (; i < block; ++i) {
+            bins[0][in[i]]++;
+        }
+
+        for (int letter = 0; letter < 26; ++letter) {
+            for (int set = 0; set < 4; ++set) {
+                counts[letter] += bins[set]['a' + letter] + bins[set]['A' + letter];
+            }
+        }
+        in += block;
+        length -= block;
     }
+}
 
-char* decryptFunc(const char* text, int key) {
-        // Assuming this function implements the decryption logic
-        int length = std::strlen(text);
-        char* decryptedText = new char[length + 1];
+void caesarRankKeys(const unsigned long long counts[26], CaesarKeyScore ranked[26]) {
+    unsigned long long total = 0;
+    for (int letter = 0; letter < 26; ++letter) {
+        total += counts[letter];
+    }
 
-        key = key % 26;
+    for (int key = 0; key < 26; ++key) {
+        double score = 0.0;
+        for (int plain = 0; plain < 26; ++plain) {
+            double expected = englishFrequency[plain] * (double)total;
+            double observed = (double)counts[(plain + key) % 26];
+            double diff = observed - expected;
+            score += expected > 0.0 ? diff * diff / expected : observed;
+        }
+        ranked[key].key = key;
+        ranked[key].score = score;
+    }
 
-        for (int i = 0; i < length; ++i) {
-            char ch = text[i];
+    std::sort(ranked, ranked + 26, [](const CaesarKeyScore& a, const CaesarKeyScore& b) {
+        return a.score < b.score || (a.score == b.score && a.key < b.key);
+    });
+}
 
-            if (ch >= 'a' && ch <= 'z') {
-                decryptedText[i] = 'a' + (ch - 'a' - key + 26) % 26;
-            } else if (ch >= 'A' && ch <= 'Z') {
-                decryptedText[i] = 'A' + (ch - 'A' - key + 26) % 26;
-            } else {
-                decryptedText[i] = ch;
+#define CRACK_WINDOW (64 * 1024)
+
+int caesarCrackFile(const char* filename, unsigned long long sample_limit, CaesarKeyScore ranked[26]) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    unsigned long long size = (unsigned long long)info.st_size;
+    unsigned long long windows = 1;
+    unsigned long long stride = 0;
+    if (sample_limit != 0 && size > sample_limit) {
+        windows = (sample_limit + CRACK_WINDOW - 1) / CRACK_WINDOW;
+        stride = size / windows;
+    }
+
+    unsigned long long counts[26] = {};
+    char buffer[CRACK_WINDOW];
+    for (unsigned long long w = 0; w < windows; ++w) {
+        off_t offset = (off_t)(w * stride);
+        unsigned long long remaining = stride == 0 ? size : CRACK_WINDOW;
+        while (remaining > 0) {
+            size_t want = remaining < sizeof(buffer) ? (size_t)remaining : sizeof(buffer);
+            ssize_t got = pread(fd, buffer, want, offset);
+            if (got < 0 && errno == EINTR) {
+                continue;
             }
+            if (got < 0) {
+                close(fd);
+                return -1;
+            }
+            if (got == 0) {
+                break;
+            }
+            caesarLetterHistogram(buffer, (size_t)got, counts);
+            offset += got;
+            remaining -= (unsigned long long)got;
         }
+    }
+    close(fd);
+
+    caesarRankKeys(counts, ranked);
+    return 0;
+}
+
+    char* encrypt(const char* rawText, int key) {
+        size_t length = strlen(rawText);
+        char* encryptedText = new char[length + 1];
+
+        encryptBuffer(rawText, encryptedText, length, key);
+        encryptedText[length] = '\0';
+
+        return encryptedText;
+    }
+
+char* decryptFunc(const char* text, int key) {
+        size_t length = std::strlen(text);
+        char* decryptedText = new char[length + 1];
+
+        decryptBuffer(text, decryptedText, length, key);
 
         decryptedText[length] = '\0';
         return decryptedText;
@@ -53,3 +543,23 @@ char* decrypt(const char* text, int key) {
         return decryptFunc(text, key);
     }
 
+static CipherVTable buildVTable() {
+    CipherVTable table = {};
+    table.abi_version = CIPHER_ABI_VERSION;
+    table.struct_size = sizeof(CipherVTable);
+    table.capabilities = CIPHER_CAP_IN_PLACE | CIPHER_CAP_BATCH | CIPHER_CAP_REKEY;
+    table.preferred_alignment = 32;
+    table.simd_level = kernelSimdLevel();
+    table.name = "caesar";
+    table.encrypt = encryptBuffer;
+    table.decrypt = decryptBuffer;
+    table.encrypt_batch = encryptBatch;
+    table.decrypt_batch = decryptBatch;
+    table.rekey = rekeyBuffer;
+    return table;
+}
+
+extern "C" CIPHER_EXPORT const CipherVTable* get_cipher_vtable() {
+    static const CipherVTable table = buildVTable();
+    return &table;
+}
@@ -1,8 +1,99 @@
 #ifndef CAESAR_H
 #define CAESAR_H
 
+#include <cstddef>
+#include <cstdint>
+
 char* encrypt(const char* text, int key);
 char* decrypt(const char* text, int key);
 
-#endif // CAESAR_H
+// Length-aware variants that write into a caller-owned buffer. dst may be the
+// same pointer as src; nothing is allocated and no terminator is written.
+void encryptBuffer(const char* src, char* dst, size_t length, int key);
+void decryptBuffer(const char* src, char* dst, size_t length, int key);
+
+void encryptInPlace(char* text, size_t length, int key);
+void decryptInPlace(char* text, size_t length, int key);
+
+// Turns text encrypted with old_key into text encrypted with new_key in one
+// pass; shifts compose, so the plaintext never exists in between.
+void rekeyBuffer(const char* src, char* dst, size_t length, int old_key, int new_key);
+
+// CRC32C of a buffer, hardware-accelerated with SSE4.2 where available.
+uint32_t caesarCrc32c(const char* data, size_t length);
+
+// Encrypt/decrypt fused with a CRC32C of the ciphertext (the output when
+// encrypting, the input when decrypting), computed in the same pass.
+uint32_t encryptBufferCrc32c(const char* src, char* dst, size_t length, int key);
+uint32_t decryptBufferCrc32c(const char* src, char* dst, size_t length, int key);
+
+// Below this size the parallel entry points stay on the calling thread.
+#define CAESAR_PARALLEL_THRESHOLD (1 << 20)
+// Work unit handed to each worker; small enough to stay in L2.
+#define CAESAR_PARALLEL_CHUNK (256 * 1024)
+
+// Same contract as encryptBuffer/decryptBuffer, but large buffers are split into
+// CAESAR_PARALLEL_CHUNK pieces spread over `threads` workers (0 = one per
+// hardware thread). The calling thread takes part and the call returns only
+// once every chunk is done.
+void encryptParallel(const char* src, char* dst, size_t length, int key, unsigned threads);
+void decryptParallel(const char* src, char* dst, size_t length, int key, unsigned threads);
+
+// One (pointer, length) piece of a batch call. dst may equal src; distinct
+// spans must not overlap.
+struct CaesarSpan {
+    const char* src;
+    char* dst;
+    size_t length;
+};
+
+// Transforms every span in one call. Short spans are gathered into a staging
+// buffer so the vector kernel runs across span boundaries instead of falling
+// into its scalar tail for each line.
+void encryptBatch(const CaesarSpan* spans, size_t count, int key);
+void decryptBatch(const CaesarSpan* spans, size_t count, int key);
+
+// Stateful streaming interface for input that never sits in memory as a whole.
+// Caesar is a pure byte map, so the context only holds the normalized shift and
+// a running byte count; chunk boundaries can fall anywhere.
+struct CaesarStream {
+    int shift;
+    unsigned long long bytes_processed;
+};
 
+#define CAESAR_STREAM_BUFFER (64 * 1024)
+
+void caesarStreamInit(CaesarStream* stream, int key, bool decrypting);
+void caesarStreamInitRekey(CaesarStream* stream, int old_key, int new_key);
+
+// Transforms min(in_length, out_capacity) bytes of `in` into `out` (which may
+// alias `in`) and returns how many were consumed.
+size_t caesarStreamUpdate(CaesarStream* stream, const char* in, size_t in_length, char* out, size_t out_capacity);
+
+// Pumps in_fd to EOF through a fixed CAESAR_STREAM_BUFFER and writes the result
+// to out_fd. Returns the number of bytes written, or -1 with errno set.
+long long caesarStreamPipe(CaesarStream* stream, int in_fd, int out_fd);
+
+// Key recovery by frequency analysis. A candidate's score is the chi-squared
+// distance between the histogram shifted back by that key and English letter
+// frequencies, so lower is better.
+struct CaesarKeyScore {
+    int key;
+    double score;
+};
+
+// Adds the case-folded letter counts of `text` to counts[0..25].
+void caesarLetterHistogram(const char* text, size_t length, unsigned long long counts[26]);
+
+// Scores all 26 keys against the histogram and writes them best first.
+void caesarRankKeys(const unsigned long long counts[26], CaesarKeyScore ranked[26]);
+
+// Default number of bytes sampled from a file when cracking.
+#define CAESAR_CRACK_SAMPLE (64u << 20)
+
+// Histograms up to sample_limit bytes of the file (0 = all of it), taken as
+// evenly spaced windows so huge inputs cost a bounded read, and ranks the keys.
+// Returns 0 on success or -1 if the file cannot be read.
+int caesarCrackFile(const char* filename, unsigned long long sample_limit, CaesarKeyScore ranked[26]);
+
+#endif // CAESAR_H
@@ -0,0 +1,59 @@
+#ifndef CIPHER_PLUGIN_H
+#define CIPHER_PLUGIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include "caesar.h"
+
+// Binary interface between the editor and a cipher build loaded at runtime
+// (./libcrypt.so). A plugin exports exactly one symbol, get_cipher_vtable, and
+// everything else is reached through the returned table. Bump
+// CIPHER_ABI_VERSION whenever an existing field changes meaning; new fields go
+// at the end and are detected through struct_size.
+//
+// File encryption runs every block of the file through the table, possibly
+// from several threads at once on disjoint buffers, so the entry points must
+// not keep state between calls.
+
+#define CIPHER_ABI_VERSION 1
+#define CIPHER_VTABLE_SYMBOL "get_cipher_vtable"
+
+// Capability flags.
+#define CIPHER_CAP_IN_PLACE 0x1u  // encrypt/decrypt accept dst == src
+#define CIPHER_CAP_BATCH    0x2u  // encrypt_batch/decrypt_batch are set
+#define CIPHER_CAP_REKEY    0x4u  // rekey is set
+
+// Plugins are built with hidden visibility so that their calls between their
+// own functions cannot be bound to a copy of the same names already loaded in
+// the host (libcaesar.so); only the entry point is exported.
+#define CIPHER_EXPORT __attribute__((visibility("default")))
+
+// Widest instruction set the plugin's kernels use on this host.
+#define CIPHER_SIMD_SCALAR 0u
+#define CIPHER_SIMD_SSE2   1u
+#define CIPHER_SIMD_AVX2   2u
+
+extern "C" {
+
+struct CipherVTable {
+    uint32_t abi_version;
+    uint32_t struct_size;
+    uint32_t capabilities;
+    uint32_t preferred_alignment;
+    uint32_t simd_level;
+    const char* name;
+
+    void (*encrypt)(const char* src, char* dst, size_t length, int key);
+    void (*decrypt)(const char* src, char* dst, size_t length, int key);
+    void (*encrypt_batch)(const CaesarSpan* spans, size_t count, int key);
+    void (*decrypt_batch)(const CaesarSpan* spans, size_t count, int key);
+    void (*rekey)(const char* src, char* dst, size_t length, int old_key, int new_key);
+};
+
+typedef const CipherVTable* (*GetCipherVTableFunc)();
+
+CIPHER_EXPORT const CipherVTable* get_cipher_vtable();
+
+}
+
+#endif // CIPHER_PLUGIN_H
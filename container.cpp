@@ -0,0 +1,569 @@
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "caesar.h"
+#include "container.h"
+#include "io_util.h"
+#include "line_scan.h"
+#include "lz.h"
+
+static const char headerMagic[4] = {'C', 'Z', 'C', '1'};
+static const char footerMagic[4] = {'C', 'Z', 'C', 'I'};
+
+bool containerIsFile(const char* path) {
+    CipherContainer container;
+    if (containerOpen(&container, path) != 0) {
+        return false;
+    }
+    containerClose(&container);
+    return true;
+}
+
+// ---- chunk pipeline ----
+
+// Chunks change size when they are compressed, so they cannot travel through
+// pipelineRun's fixed-size blocks. Here a pool of workers each claims the next
+// chunk (claims are serialized, so sequential reads stay in order), transforms
+// it outside the lock and parks it by number, while the calling thread writes
+// chunks strictly in order as they become ready. Reading, transforming and
+// writing different chunks overlap, and memory stays at one buffer set per
+// slot.
+
+// Memory the slots of one run may take together.
+#define CONTAINER_PIPELINE_MEMORY (64u << 20)
+
+struct ContainerSlot {
+    uint64_t chunk;
+    std::vector<char> data;
+    std::vector<char> spare;   // compression output when encrypting
+    size_t length;             // bytes read into data
+    char* stored;              // bytes to write: data or spare
+    size_t stored_size;
+    uint32_t crc32c;
+    uint64_t lines;
+    bool ends_with_newline;
+    long long status;          // decrypted size, or a CONTAINER_ERROR_* code
+};
+
+// Sizes the slots for a run over about `chunks` chunks, each slot holding
+// data_size + spare_size bytes, and returns how many workers to start.
+static unsigned planChunks(std::vector<ContainerSlot>& slots, uint64_t chunks, size_t data_size, size_t spare_size) {
+    unsigned workers = std::thread::hardware_concurrency();
+    // Even on one core a second worker keeps a read going during a transform.
+    if (workers < 2) {
+        workers = 2;
+    }
+    uint64_t count = CONTAINER_PIPELINE_MEMORY / (data_size + spare_size);
+    if (count > 2ull * workers) {
+        count = 2ull * workers;
+    }
+    if (count > chunks) {
+        count = chunks;
+    }
+    if (count < 2) {
+        count = 2;
+    }
+    if (workers > count) {
+        workers = (unsigned)count;
+    }
+    slots.resize((size_t)count);
+    for (ContainerSlot& slot : slots) {
+        slot.data.resize(data_size);
+        slot.spare.resize(spare_size);
+    }
+    return workers;
+}
+
+// Runs the three stages over the slots. claim(slot, chunk) fills a slot with
+// chunk number `chunk` and returns 1, 0 when there are no more, or a negative
+// status; it runs under the claim lock. process(slot) runs on the workers in
+// parallel. write(slot) runs on the calling thread in chunk order and returns
+// 0 or a negative status, which stops the run. Returns the first failure: a
+// write status, else a claim status, else 0.
+template <typename Claim, typename Process, typename Write>
+static int runChunks(std::vector<ContainerSlot>& slots, unsigned workers, Claim claim, Process process, Write write) {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::vector<ContainerSlot*> free_slots;
+    std::map<uint64_t, ContainerSlot*> ready;
+    unsigned running = workers;
+    bool stopping = false;
+
+    std::mutex claim_lock;
+    uint64_t next_claim = 0;
+    bool exhausted = false;
+    int claim_status = 0;
+
+    for (ContainerSlot& slot : slots) {
+        free_slots.push_back(&slot);
+    }
+
+    auto worker = [&]() {
+        while (true) {
+            ContainerSlot* slot;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                changed.wait(guard, [&]() { return !free_slots.empty() || stopping; });
+                if (stopping) {
+                    break;
+                }
+                slot = free_slots.back();
+                free_slots.pop_back();
+            }
+            int claimed = 0;
+            {
+                std::lock_guard<std::mutex> guard(claim_lock);
+                if (!exhausted) {
+                    claimed = claim(slot, next_claim);
+                    if (claimed > 0) {
+                        slot->chunk = next_claim++;
+                    } else {
+                        exhausted = true;
+                        claim_status = claimed;
+                    }
+                }
+            }
+            if (claimed <= 0) {
+                std::lock_guard<std::mutex> guard(lock);
+                free_slots.push_back(slot);
+                break;
+            }
+            process(slot);
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                ready[slot->chunk] = slot;
+            }
+            changed.notify_all();
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            running--;
+        }
+        changed.notify_all();
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i) {
+        pool.emplace_back(worker);
+    }
+
+    // Chunks are claimed in order and every claimed chunk ends up in ready,
+    // so once the workers are gone a missing next chunk means the end.
+    int status = 0;
+    for (uint64_t next_write = 0; status == 0; ++next_write) {
+        ContainerSlot* slot;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [&]() { return ready.count(next_write) != 0 || running == 0; });
+            std::map<uint64_t, ContainerSlot*>::iterator found = ready.find(next_write);
+            if (found == ready.end()) {
+                break;
+            }
+            slot = found->second;
+            ready.erase(found);
+        }
+        status = write(slot);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            free_slots.push_back(slot);
+            stopping = status != 0;
+        }
+        changed.notify_all();
+    }
+
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    return status != 0 ? status : claim_status;
+}
+
+int containerEncryptFile(const char* input_path, const char* output_path, int key, uint32_t chunk_size, uint32_t flags) {
+    if (chunk_size == 0) {
+        chunk_size = CONTAINER_DEFAULT_CHUNK;
+    }
+    if (chunk_size > CONTAINER_MAX_CHUNK) {
+        return -1;
+    }
+    int in_fd = open(input_path, O_RDONLY);
+    struct stat info;
+    if (in_fd < 0 || fstat(in_fd, &info) != 0) {
+        if (in_fd >= 0) {
+            close(in_fd);
+        }
+        return -1;
+    }
+    // Encrypting a file onto itself writes a replacement and renames it over
+    // the input; truncating in place would feed the output back in.
+    char* temporary = nullptr;
+    int out_fd = isSameFile(info, output_path)
+        ? openReplacement(output_path, info.st_mode, &temporary)
+        : open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0) {
+        close(in_fd);
+        return -1;
+    }
+    posix_fadvise(in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    unsigned char header[CONTAINER_HEADER_SIZE] = {};
+    memcpy(header, headerMagic, sizeof(headerMagic));
+    putU32(header + 4, CONTAINER_VERSION);
+    putU32(header + 8, chunk_size);
+    putU32(header + 12, flags);
+
+    // Pipes and devices have no size; plan for as many chunks as slots allow.
+    uint64_t chunks = S_ISREG(info.st_mode) ? (uint64_t)info.st_size / chunk_size + 1 : UINT64_MAX;
+    std::vector<ContainerSlot> slots;
+    unsigned workers = planChunks(slots, chunks, chunk_size,
+                                  (flags & CONTAINER_FLAG_COMPRESSED) ? lzCompressBound(chunk_size) : 0);
+    std::vector<ContainerChunk> index;
+    uint64_t offset = CONTAINER_HEADER_SIZE;
+    uint64_t lines = 0;
+    uint64_t plain_size = 0;
+    bool last_was_newline = true;
+    bool ok = writeAll(out_fd, (const char*)header, sizeof(header));
+
+    auto claim = [&](ContainerSlot* slot, uint64_t) {
+        ssize_t got = readFull(in_fd, slot->data.data(), chunk_size);
+        if (got <= 0) {
+            return got < 0 ? -1 : 0;
+        }
+        slot->length = (size_t)got;
+        return 1;
+    };
+    // Compress, then shift. A chunk that does not shrink is stored as is;
+    // readers tell the two apart by stored_size < plain_size.
+    auto process = [&](ContainerSlot* slot) {
+        slot->lines = lineScanCount(slot->data.data(), slot->length);
+        slot->ends_with_newline = slot->data[slot->length - 1] == '\n';
+        slot->stored = slot->data.data();
+        slot->stored_size = slot->length;
+        if (flags & CONTAINER_FLAG_COMPRESSED) {
+            size_t packed_size = lzCompress(slot->data.data(), slot->length, slot->spare.data(), slot->spare.size());
+            if (packed_size > 0 && packed_size < slot->length) {
+                slot->stored = slot->spare.data();
+                slot->stored_size = packed_size;
+            }
+        }
+        slot->crc32c = encryptBufferCrc32c(slot->stored, slot->stored, slot->stored_size, key);
+    };
+    auto write = [&](ContainerSlot* slot) {
+        ContainerChunk entry;
+        entry.offset = offset;
+        entry.stored_size = (uint32_t)slot->stored_size;
+        entry.plain_size = (uint32_t)slot->length;
+        entry.first_line = lines;
+        entry.crc32c = slot->crc32c;
+        index.push_back(entry);
+        lines += slot->lines;
+        last_was_newline = slot->ends_with_newline;
+        plain_size += slot->length;
+        offset += slot->stored_size;
+        return writeAll(out_fd, slot->stored, slot->stored_size) ? 0 : -1;
+    };
+    if (ok) {
+        ok = runChunks(slots, workers, claim, process, write) == 0;
+    }
+    // A final line without a trailing newline still counts as a line.
+    if (!last_was_newline) {
+        ++lines;
+    }
+
+    if (ok) {
+        std::vector<unsigned char> table(index.size() * CONTAINER_INDEX_ENTRY_SIZE);
+        for (size_t i = 0; i < index.size(); ++i) {
+            unsigned char* entry = table.data() + i * CONTAINER_INDEX_ENTRY_SIZE;
+            putU64(entry, index[i].offset);
+            putU32(entry + 8, index[i].stored_size);
+            putU32(entry + 12, index[i].plain_size);
+            putU64(entry + 16, index[i].first_line);
+            putU32(entry + 24, index[i].crc32c);
+            putU32(entry + 28, 0);
+        }
+        unsigned char footer[CONTAINER_FOOTER_SIZE] = {};
+        putU64(footer, offset);
+        putU64(footer + 8, index.size());
+        putU64(footer + 16, lines);
+        putU64(footer + 24, plain_size);
+        putU32(footer + 32, caesarCrc32c((const char*)table.data(), table.size()));
+        memcpy(footer + 36, footerMagic, sizeof(footerMagic));
+        ok = writeAll(out_fd, (const char*)table.data(), table.size())
+            && writeAll(out_fd, (const char*)footer, sizeof(footer));
+    }
+
+    close(in_fd);
+    if (close(out_fd) != 0) {
+        ok = false;
+    }
+    if (temporary != nullptr) {
+        ok = finishReplacement(temporary, output_path, ok);
+    }
+    return ok ? 0 : -1;
+}
+
+int containerOpen(CipherContainer* container, const char* path) {
+    container->fd = -1;
+    container->index = nullptr;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    off_t file_size = lseek(fd, 0, SEEK_END);
+    unsigned char header[CONTAINER_HEADER_SIZE];
+    unsigned char footer[CONTAINER_FOOTER_SIZE];
+    if (file_size < CONTAINER_HEADER_SIZE + CONTAINER_FOOTER_SIZE
+        || preadFull(fd, (char*)header, sizeof(header), 0) != (ssize_t)sizeof(header)
+        || preadFull(fd, (char*)footer, sizeof(footer), file_size - CONTAINER_FOOTER_SIZE) != (ssize_t)sizeof(footer)
+        || memcmp(header, headerMagic, sizeof(headerMagic)) != 0
+        || memcmp(footer + 36, footerMagic, sizeof(footerMagic)) != 0
+        || getU32(header + 4) != CONTAINER_VERSION
+        || getU32(header + 8) == 0
+        || getU32(header + 8) > CONTAINER_MAX_CHUNK) {
+        close(fd);
+        return -1;
+    }
+
+    uint64_t index_offset = getU64(footer);
+    uint64_t chunk_count = getU64(footer + 8);
+    // Bound both fields by the file size first so the sum below cannot wrap.
+    uint64_t body_size = (uint64_t)file_size - CONTAINER_HEADER_SIZE - CONTAINER_FOOTER_SIZE;
+    if (index_offset < CONTAINER_HEADER_SIZE || index_offset > (uint64_t)file_size
+        || chunk_count > body_size / CONTAINER_INDEX_ENTRY_SIZE
+        || index_offset + chunk_count * CONTAINER_INDEX_ENTRY_SIZE + CONTAINER_FOOTER_SIZE != (uint64_t)file_size) {
+        close(fd);
+        return -1;
+    }
+
+    std::vector<unsigned char> table(chunk_count * CONTAINER_INDEX_ENTRY_SIZE);
+    if (preadFull(fd, (char*)table.data(), table.size(), (off_t)index_offset) != (ssize_t)table.size()
+        || caesarCrc32c((const char*)table.data(), table.size()) != getU32(footer + 32)) {
+        close(fd);
+        return -1;
+    }
+    // Every chunk must fit the header's chunk size and lie within the body.
+    uint32_t chunk_size = getU32(header + 8);
+    ContainerChunk* index = new ContainerChunk[chunk_count];
+    for (uint64_t i = 0; i < chunk_count; ++i) {
+        const unsigned char* entry = table.data() + i * CONTAINER_INDEX_ENTRY_SIZE;
+        index[i].offset = getU64(entry);
+        index[i].stored_size = getU32(entry + 8);
+        index[i].plain_size = getU32(entry + 12);
+        index[i].first_line = getU64(entry + 16);
+        index[i].crc32c = getU32(entry + 24);
+        if (index[i].plain_size > chunk_size || index[i].stored_size > index[i].plain_size
+            || index[i].offset < CONTAINER_HEADER_SIZE || index[i].offset > index_offset
+            || index[i].stored_size > index_offset - index[i].offset) {
+            delete[] index;
+            close(fd);
+            return -1;
+        }
+    }
+
+    container->fd = fd;
+    container->chunk_size = chunk_size;
+    container->flags = getU32(header + 12);
+    container->chunk_count = chunk_count;
+    container->line_count = getU64(footer + 16);
+    container->plain_size = getU64(footer + 24);
+    container->index = index;
+    return 0;
+}
+
+void containerClose(CipherContainer* container) {
+    if (container->fd >= 0) {
+        close(container->fd);
+    }
+    delete[] container->index;
+    container->fd = -1;
+    container->index = nullptr;
+}
+
+// Reads the stored bytes of a chunk into out. Returns the stored size or an
+// error code.
+static long long readStoredChunk(const CipherContainer* container, uint64_t chunk, char* out) {
+    if (chunk >= container->chunk_count) {
+        return CONTAINER_ERROR_IO;
+    }
+    const ContainerChunk& entry = container->index[chunk];
+    if (entry.plain_size > container->chunk_size || entry.stored_size > entry.plain_size) {
+        return CONTAINER_ERROR_CORRUPT;
+    }
+    if (preadFull(container->fd, out, entry.stored_size, (off_t)entry.offset) != (ssize_t)entry.stored_size) {
+        return CONTAINER_ERROR_IO;
+    }
+    return entry.stored_size;
+}
+
+long long containerReadChunk(const CipherContainer* container, uint64_t chunk, int key, char* out) {
+    if (chunk >= container->chunk_count) {
+        return CONTAINER_ERROR_IO;
+    }
+    const ContainerChunk& entry = container->index[chunk];
+    bool compressed = entry.stored_size < entry.plain_size;
+
+    // Compressed chunks are staged separately and expanded into out.
+    static thread_local std::vector<char> staging;
+    char* stored = out;
+    if (compressed) {
+        staging.resize(container->chunk_size);
+        stored = staging.data();
+    }
+
+    long long stored_size = readStoredChunk(container, chunk, stored);
+    if (stored_size < 0) {
+        return stored_size;
+    }
+    if (decryptBufferCrc32c(stored, stored, (size_t)stored_size, key) != entry.crc32c) {
+        return CONTAINER_ERROR_CORRUPT;
+    }
+    if (compressed && lzDecompress(stored, (size_t)stored_size, out, container->chunk_size) != (long long)entry.plain_size) {
+        return CONTAINER_ERROR_CORRUPT;
+    }
+    return entry.plain_size;
+}
+
+char* containerReadLines(const CipherContainer* container, int key, uint64_t first_line, uint64_t count, size_t* length) {
+    *length = 0;
+    std::vector<char> result;
+    if (count == 0 || first_line >= container->line_count) {
+        char* empty = (char*)malloc(1);
+        if (empty != nullptr) {
+            empty[0] = '\0';
+        }
+        return empty;
+    }
+
+    // Line n starts right after the n-th newline, which lies in the last chunk
+    // that has fewer than n newlines before it.
+    uint64_t chunk = 0;
+    if (first_line > 0) {
+        uint64_t low = 0;
+        uint64_t high = container->chunk_count;
+        while (high - low > 1) {
+            uint64_t mid = low + (high - low) / 2;
+            if (container->index[mid].first_line < first_line) {
+                low = mid;
+            } else {
+                high = mid;
+            }
+        }
+        chunk = low;
+    }
+
+    std::vector<char> plain(container->chunk_size);
+    uint64_t line = container->index[chunk].first_line;
+    uint64_t end_line = first_line + count;
+    for (; chunk < container->chunk_count && line < end_line; ++chunk) {
+        long long got = containerReadChunk(container, chunk, key, plain.data());
+        if (got < 0) {
+            return nullptr;
+        }
+        const char* data = plain.data();
+        size_t start = 0;
+        uint64_t passed = 0;
+        if (line < first_line) {
+            start = lineScanSkip(data, (size_t)got, first_line - line, &passed);
+            line += passed;
+        }
+        if (line >= first_line && start < (size_t)got) {
+            size_t stop = start + lineScanSkip(data + start, (size_t)got - start, end_line - line, &passed);
+            result.insert(result.end(), data + start, data + stop);
+            line += passed;
+        }
+    }
+    // The last line of a file may lack its newline; terminate it uniformly.
+    if (!result.empty() && result.back() != '\n') {
+        result.push_back('\n');
+    }
+
+    char* text = (char*)malloc(result.size() + 1);
+    if (text == nullptr) {
+        return nullptr;
+    }
+    memcpy(text, result.data(), result.size());
+    text[result.size()] = '\0';
+    *length = result.size();
+    return text;
+}
+
+int containerDecryptFile(const char* input_path, const char* output_path, int key, uint64_t* bad_chunk) {
+    *bad_chunk = 0;
+    CipherContainer container;
+    if (containerOpen(&container, input_path) != 0) {
+        return CONTAINER_ERROR_IO;
+    }
+    struct stat info;
+    char* temporary = nullptr;
+    int out_fd = -1;
+    if (fstat(container.fd, &info) == 0) {
+        out_fd = isSameFile(info, output_path)
+            ? openReplacement(output_path, info.st_mode, &temporary)
+            : open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if (out_fd < 0) {
+        containerClose(&container);
+        return CONTAINER_ERROR_IO;
+    }
+
+    // Workers read and decrypt chunks with pread, so claiming one needs no I/O.
+    std::vector<ContainerSlot> slots;
+    unsigned workers = planChunks(slots, container.chunk_count, container.chunk_size, 0);
+    auto claim = [&](ContainerSlot*, uint64_t chunk) {
+        return chunk < container.chunk_count ? 1 : 0;
+    };
+    auto process = [&](ContainerSlot* slot) {
+        slot->status = containerReadChunk(&container, slot->chunk, key, slot->data.data());
+    };
+    auto write = [&](ContainerSlot* slot) {
+        if (slot->status < 0) {
+            *bad_chunk = slot->chunk;
+            return (int)slot->status;
+        }
+        return writeAll(out_fd, slot->data.data(), (size_t)slot->status) ? 0 : CONTAINER_ERROR_IO;
+    };
+    int status = runChunks(slots, workers, claim, process, write);
+
+    containerClose(&container);
+    if (close(out_fd) != 0 && status == 0) {
+        status = CONTAINER_ERROR_IO;
+    }
+    // A container decrypted onto itself is only replaced once every chunk
+    // made it; on failure the container stays as it was.
+    if (temporary != nullptr && !finishReplacement(temporary, output_path, status == 0) && status == 0) {
+        status = CONTAINER_ERROR_IO;
+    }
+    return status;
+}
+
+int containerVerifyFile(const char* path, uint64_t* bad_chunk) {
+    *bad_chunk = 0;
+    CipherContainer container;
+    if (containerOpen(&container, path) != 0) {
+        return CONTAINER_ERROR_IO;
+    }
+
+    std::vector<char> stored(container.chunk_size);
+    int status = 0;
+    for (uint64_t chunk = 0; status == 0 && chunk < container.chunk_count; ++chunk) {
+        long long got = readStoredChunk(&container, chunk, stored.data());
+        if (got < 0) {
+            status = (int)got;
+        } else if (caesarCrc32c(stored.data(), (size_t)got) != container.index[chunk].crc32c) {
+            status = CONTAINER_ERROR_CORRUPT;
+        }
+        if (status != 0) {
+            *bad_chunk = chunk;
+        }
+    }
+
+    containerClose(&container);
+    return status;
+}
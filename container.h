@@ -0,0 +1,104 @@
+#ifndef CONTAINER_H
+#define CONTAINER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Chunk-indexed encrypted file format. The plaintext is cut into fixed-size
+// chunks that are encrypted independently, and a trailing index records where
+// each chunk lives and how many lines precede it. A reader can then decrypt
+// only the chunks that cover a line range.
+//
+//   header   "CZC1", version, chunk size, flags              (32 bytes)
+//   chunks   encrypted bytes; chunk_size bytes of plaintext each
+//            except the last, LZ-compressed before the shift when
+//            CONTAINER_FLAG_COMPRESSED is set and that helps
+//   index    per chunk: file offset, stored size, plain size,
+//            lines before the chunk, CRC32C of the stored
+//            bytes                                            (32 bytes each)
+//   footer   index offset, chunk count, line count, plain
+//            size, CRC32C of the index, "CZCI"                (40 bytes)
+//
+// All integers are little-endian. Checksums cover the encrypted bytes, so a
+// file can be verified without its key.
+//
+// Encrypting and decrypting a whole file overlap reading, transforming and
+// writing: chunks are compressed and shifted (or decrypted and expanded) on a
+// pool of workers while the calling thread writes finished ones in order.
+//
+// Containers always use the built-in kernels, not a loaded cipher plugin: the
+// shift is fused with the CRC32C pass (encryptBufferCrc32c), which the plugin
+// ABI has no entry point for.
+
+#define CONTAINER_VERSION 2
+#define CONTAINER_HEADER_SIZE 32
+#define CONTAINER_INDEX_ENTRY_SIZE 32
+#define CONTAINER_FOOTER_SIZE 40
+#define CONTAINER_DEFAULT_CHUNK (1u << 20)
+// Readers allocate whole chunks, and the header is not checksummed, so larger
+// chunk sizes are rejected on both sides.
+#define CONTAINER_MAX_CHUNK (64u << 20)
+
+// Header flags.
+#define CONTAINER_FLAG_COMPRESSED 0x1u
+
+struct ContainerChunk {
+    uint64_t offset;
+    uint32_t stored_size;
+    uint32_t plain_size;
+    uint64_t first_line;
+    uint32_t crc32c;
+};
+
+struct CipherContainer {
+    int fd;
+    uint32_t chunk_size;
+    uint32_t flags;
+    uint64_t chunk_count;
+    uint64_t line_count;
+    uint64_t plain_size;
+    ContainerChunk* index;
+};
+
+// Negative status codes returned by the read paths below.
+#define CONTAINER_ERROR_IO -1
+#define CONTAINER_ERROR_CORRUPT -2
+
+// True if the file opens as a container: magic, footer and index all check
+// out. A plain encrypted file that merely starts with the magic bytes does not.
+bool containerIsFile(const char* path);
+
+// Encrypts input_path into a container at output_path, streaming it chunk by
+// chunk; chunk_size is at most CONTAINER_MAX_CHUNK (0 picks the default).
+// `flags` takes CONTAINER_FLAG_* values. An output that is the input
+// itself is written to a temporary and renamed into place. Returns 0 on
+// success or -1 on an I/O error.
+int containerEncryptFile(const char* input_path, const char* output_path, int key, uint32_t chunk_size, uint32_t flags);
+
+// Opens a container and loads its index. Returns 0, or -1 if the file cannot
+// be read or is not a valid container.
+int containerOpen(CipherContainer* container, const char* path);
+void containerClose(CipherContainer* container);
+
+// Decrypts chunk `chunk` into out, which must hold container->chunk_size bytes,
+// checking its CRC32C on the way. Returns the plain size of the chunk,
+// CONTAINER_ERROR_IO, or CONTAINER_ERROR_CORRUPT on a checksum mismatch.
+long long containerReadChunk(const CipherContainer* container, uint64_t chunk, int key, char* out);
+
+// Decrypts lines [first_line, first_line + count) and returns them as one
+// malloc'd buffer of '\n'-terminated lines, touching only the chunks that cover
+// the range. *length receives the byte count. Returns nullptr on error.
+char* containerReadLines(const CipherContainer* container, int key, uint64_t first_line, uint64_t count, size_t* length);
+
+// Decrypts the whole container into output_path, verifying chunks as they
+// stream and stopping at the first bad one; the output then holds only the
+// chunks before it. Decrypting a container onto itself replaces it only on
+// success. Returns 0, CONTAINER_ERROR_IO or CONTAINER_ERROR_CORRUPT, with the
+// failing chunk in *bad_chunk.
+int containerDecryptFile(const char* input_path, const char* output_path, int key, uint64_t* bad_chunk);
+
+// Checks every chunk's CRC32C without decrypting or writing anything. Same
+// return convention as containerDecryptFile.
+int containerVerifyFile(const char* path, uint64_t* bad_chunk);
+
+#endif // CONTAINER_H
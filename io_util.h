@@ -0,0 +1,169 @@
+#ifndef IO_UTIL_H
+#define IO_UTIL_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Small POSIX helpers shared by the file-level cipher code: retry on EINTR and
+// short transfers, safe replacement of a file that is also being read, and
+// fixed-width little-endian field encoding for on-disk structures.
+
+inline bool writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+inline bool pwriteAll(int fd, const char* data, size_t length, off_t offset) {
+    while (length > 0) {
+        ssize_t written = pwrite(fd, data, length, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= (size_t)written;
+        offset += (off_t)written;
+    }
+    return true;
+}
+
+// Reads until `length` bytes arrive or EOF. Returns the byte count, or -1.
+inline ssize_t readFull(int fd, char* data, size_t length) {
+    size_t total = 0;
+    while (total < length) {
+        ssize_t got = read(fd, data + total, length - total);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (got == 0) {
+            break;
+        }
+        total += (size_t)got;
+    }
+    return (ssize_t)total;
+}
+
+inline ssize_t preadFull(int fd, char* data, size_t length, off_t offset) {
+    size_t total = 0;
+    while (total < length) {
+        ssize_t got = pread(fd, data + total, length - total, offset + (off_t)total);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (got == 0) {
+            break;
+        }
+        total += (size_t)got;
+    }
+    return (ssize_t)total;
+}
+
+// True if path names the file described by info. Compares device and inode,
+// so different spellings of one path (and hard links) count as the same file.
+inline bool isSameFile(const struct stat& info, const char* path) {
+    struct stat other;
+    return stat(path, &other) == 0 && other.st_dev == info.st_dev && other.st_ino == info.st_ino;
+}
+
+// Writing a file's transformed contents back over itself must not truncate it
+// first. Output goes to a fresh temporary next to path (so the final rename
+// stays on one filesystem) created with the permission bits of `mode`; the
+// malloc'd name is stored in *temporary. Returns the descriptor or -1.
+inline int openReplacement(const char* path, mode_t mode, char** temporary) {
+    size_t length = strlen(path);
+    char* name = (char*)malloc(length + 8);
+    *temporary = nullptr;
+    if (name == nullptr) {
+        errno = ENOMEM;
+        return -1;
+    }
+    memcpy(name, path, length);
+    memcpy(name + length, ".XXXXXX", 8);
+    int fd = mkstemp(name);
+    if (fd < 0 || fchmod(fd, mode & 07777) != 0) {
+        int saved = errno;
+        if (fd >= 0) {
+            close(fd);
+            unlink(name);
+        }
+        free(name);
+        errno = saved;
+        return -1;
+    }
+    *temporary = name;
+    return fd;
+}
+
+// Renames a complete replacement over path, or removes it when the write
+// failed (ok == false). Frees the name. Returns false with errno set if the
+// rename itself fails.
+inline bool finishReplacement(char* temporary, const char* path, bool ok) {
+    if (ok && rename(temporary, path) != 0) {
+        int saved = errno;
+        unlink(temporary);
+        free(temporary);
+        errno = saved;
+        return false;
+    }
+    if (!ok) {
+        int saved = errno;
+        unlink(temporary);
+        errno = saved;
+    }
+    free(temporary);
+    return ok;
+}
+
+inline void putU32(unsigned char* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+inline void putU64(unsigned char* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+inline uint32_t getU32(const unsigned char* in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+inline uint64_t getU64(const unsigned char* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+#endif // IO_UTIL_H
@@ -0,0 +1,210 @@
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "line_scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LINE_SCAN_X86 1
+#endif
+
+static uint64_t countScalar(const char* data, size_t length) {
+    uint64_t lines = 0;
+    const char* end = data + length;
+    while ((data = (const char*)memchr(data, '\n', end - data)) != nullptr) {
+        ++lines;
+        ++data;
+    }
+    return lines;
+}
+
+static size_t startsScalar(const char* data, size_t length, uint64_t base, uint64_t* starts, size_t max_starts) {
+    size_t written = 0;
+    const char* cursor = data;
+    const char* end = data + length;
+    while (written < max_starts && (cursor = (const char*)memchr(cursor, '\n', end - cursor)) != nullptr) {
+        ++cursor;
+        starts[written++] = base + (uint64_t)(cursor - data);
+    }
+    return written;
+}
+
+static size_t skipScalar(const char* data, size_t length, uint64_t lines, uint64_t* passed) {
+    const char* cursor = data;
+    const char* end = data + length;
+    uint64_t found = 0;
+    while (found < lines && (cursor = (const char*)memchr(cursor, '\n', end - cursor)) != nullptr) {
+        ++cursor;
+        ++found;
+    }
+    *passed = found;
+    return found < lines ? length : (size_t)(cursor - data);
+}
+
+#ifdef LINE_SCAN_X86
+__attribute__((target("avx2")))
+static inline uint32_t newlineMask(const char* p) {
+    __m256i bytes = _mm256_loadu_si256((const __m256i*)p);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')));
+}
+
+__attribute__((target("avx2")))
+static uint64_t countAvx2(const char* data, size_t length) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t lines = 0;
+    size_t i = 0;
+    while (i + 32 <= length) {
+        // Each match subtracts -1 from a byte lane; 255 blocks cannot overflow
+        // it, then the lanes are summed with SAD.
+        __m256i counts = zero;
+        size_t block_end = length - i > 255 * 32 ? i + 255 * 32 : length;
+        for (; i + 32 <= block_end; i += 32) {
+            __m256i bytes = _mm256_loadu_si256((const __m256i*)(data + i));
+            counts = _mm256_sub_epi8(counts, _mm256_cmpeq_epi8(bytes, newline));
+        }
+        __m256i sums = _mm256_sad_epu8(counts, zero);
+        lines += (uint64_t)_mm256_extract_epi64(sums, 0) + (uint64_t)_mm256_extract_epi64(sums, 1)
+               + (uint64_t)_mm256_extract_epi64(sums, 2) + (uint64_t)_mm256_extract_epi64(sums, 3);
+    }
+    _mm256_zeroupper();
+    return lines + countScalar(data + i, length - i);
+}
+
+__attribute__((target("avx2,bmi")))
+static size_t startsAvx2(const char* data, size_t length, uint64_t base, uint64_t* starts, size_t max_starts) {
+    size_t written = 0;
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        uint32_t mask = newlineMask(data + i);
+        while (mask != 0) {
+            if (written == max_starts) {
+                _mm256_zeroupper();
+                return written;
+            }
+            starts[written++] = base + i + _tzcnt_u32(mask) + 1;
+            mask &= mask - 1;
+        }
+    }
+    _mm256_zeroupper();
+    return written + startsScalar(data + i, length - i, base + i, starts + written, max_starts - written);
+}
+
+__attribute__((target("avx2,bmi,popcnt")))
+static size_t skipAvx2(const char* data, size_t length, uint64_t lines, uint64_t* passed) {
+    uint64_t found = 0;
+    size_t i = 0;
+    if (lines == 0) {
+        *passed = 0;
+        return 0;
+    }
+    for (; i + 32 <= length; i += 32) {
+        uint32_t mask = newlineMask(data + i);
+        uint64_t in_block = (uint64_t)_mm_popcnt_u32(mask);
+        if (found + in_block < lines) {
+            found += in_block;
+            continue;
+        }
+        // The target newline is in this block: drop the ones before it.
+        for (uint64_t k = found + 1; k < lines; ++k) {
+            mask &= mask - 1;
+        }
+        _mm256_zeroupper();
+        *passed = lines;
+        return i + _tzcnt_u32(mask) + 1;
+    }
+    _mm256_zeroupper();
+    uint64_t tail_passed = 0;
+    size_t offset = skipScalar(data + i, length - i, lines - found, &tail_passed);
+    *passed = found + tail_passed;
+    return i + offset;
+}
+#endif
+
+struct LineScanKernels {
+    uint64_t (*count)(const char*, size_t);
+    size_t (*starts)(const char*, size_t, uint64_t, uint64_t*, size_t);
+    size_t (*skip)(const char*, size_t, uint64_t, uint64_t*);
+};
+
+static LineScanKernels selectKernels() {
+#ifdef LINE_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") && __builtin_cpu_supports("popcnt")) {
+        return LineScanKernels{countAvx2, startsAvx2, skipAvx2};
+    }
+#endif
+    return LineScanKernels{countScalar, startsScalar, skipScalar};
+}
+
+static const LineScanKernels lineScanKernels = selectKernels();
+
+uint64_t lineScanCount(const char* data, size_t length) {
+    return lineScanKernels.count(data, length);
+}
+
+size_t lineScanStarts(const char* data, size_t length, uint64_t base, uint64_t* starts, size_t max_starts) {
+    return lineScanKernels.starts(data, length, base, starts, max_starts);
+}
+
+size_t lineScanSkip(const char* data, size_t length, uint64_t lines, uint64_t* passed) {
+    return lineScanKernels.skip(data, length, lines, passed);
+}
+
+// Runs body(0) .. body(workers - 1), one per thread, the last on the caller.
+template <typename Body>
+static void runWorkers(unsigned workers, Body body) {
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (unsigned i = 0; i + 1 < workers; ++i) {
+        pool.emplace_back(body, i);
+    }
+    body(workers - 1);
+    for (std::thread& t : pool) {
+        t.join();
+    }
+}
+
+uint64_t* lineScanIndex(const char* data, size_t length, unsigned threads, uint64_t* newlines) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    size_t most = length / LINE_SCAN_PARALLEL_RANGE;
+    if (threads > most) {
+        threads = (unsigned)most;
+    }
+    if (threads <= 1) {
+        uint64_t total = length > 0 ? lineScanCount(data, length) : 0;
+        uint64_t* starts = new uint64_t[total + 2];
+        starts[0] = 0;
+        lineScanStarts(data, length, 0, starts + 1, (size_t)total);
+        *newlines = total;
+        return starts;
+    }
+
+    // Equal byte ranges. Every newline falls in exactly one of them, so the
+    // ranges need no alignment: a prefix sum of the per-range counts tells
+    // each worker where its entries go, and the second pass writes them
+    // straight into place, already in order.
+    size_t range = (length + threads - 1) / threads;
+    std::vector<uint64_t> first(threads + 1, 0);
+    runWorkers(threads, [&](unsigned i) {
+        size_t begin = (size_t)i * range;
+        size_t end = begin + range < length ? begin + range : length;
+        first[i + 1] = begin < end ? lineScanCount(data + begin, end - begin) : 0;
+    });
+    for (unsigned i = 0; i < threads; ++i) {
+        first[i + 1] += first[i];
+    }
+    uint64_t* starts = new uint64_t[first[threads] + 2];
+    starts[0] = 0;
+    runWorkers(threads, [&](unsigned i) {
+        size_t begin = (size_t)i * range;
+        size_t end = begin + range < length ? begin + range : length;
+        if (begin < end) {
+            lineScanStarts(data + begin, end - begin, begin, starts + 1 + first[i], (size_t)(first[i + 1] - first[i]));
+        }
+    });
+    *newlines = first[threads];
+    return starts;
+}
@@ -0,0 +1,37 @@
+#ifndef LINE_SCAN_H
+#define LINE_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Newline scanning at memory bandwidth. The AVX2 kernels compare 32 bytes
+// against '\n' at once and turn the result into a bitmask; counting sums the
+// matches in byte lanes, and position extraction walks the mask with tzcnt.
+// Other hosts fall back to memchr. The kernel is picked once at load time.
+//
+// Only '\n' ends a line. For "\r\n" text the '\r' is the last byte of the line
+// as far as these functions are concerned; callers that want it gone trim it
+// when they take the line's text.
+
+// Number of '\n' bytes in data.
+uint64_t lineScanCount(const char* data, size_t length);
+
+// Writes base + i + 1 for each '\n' at data[i], that is the offset where the
+// next line starts, stopping after max_starts entries. Returns how many were
+// written.
+size_t lineScanStarts(const char* data, size_t length, uint64_t base, uint64_t* starts, size_t max_starts);
+
+// Returns the offset just past the `lines`-th '\n' in data, or length if there
+// are fewer; *passed receives the number of newlines stepped over.
+size_t lineScanSkip(const char* data, size_t length, uint64_t lines, uint64_t* passed);
+
+// Below this many bytes per worker lineScanIndex stays on the calling thread.
+#define LINE_SCAN_PARALLEL_RANGE (4u << 20)
+
+// Indexes a whole buffer on up to `threads` workers (0 = one per hardware
+// thread). Returns a new[]'d array of *newlines + 2 entries: 0, then what
+// lineScanStarts writes for the buffer. The last entry is left to the caller,
+// typically for an end sentinel.
+uint64_t* lineScanIndex(const char* data, size_t length, unsigned threads, uint64_t* newlines);
+
+#endif // LINE_SCAN_H
@@ -0,0 +1,297 @@
+#ifndef LINE_TABLE_H
+#define LINE_TABLE_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "line_scan.h"
+#include "text_container.h"
+
+// Clean (unedited) lines kept materialized beyond this many bytes are evicted.
+#define LINE_TABLE_MEMORY_BUDGET (64u << 20)
+
+#define LINE_DIRTY 0x1
+#define LINE_REFERENCED 0x2
+
+// Lines whose text differs from the backing file, with their contents, plus
+// the line count. Everything else in a snapshot is implied by the file.
+struct LineSnapshot {
+    long long line_count;
+    std::vector<long long> dirty_lines;
+    std::vector<TextContainer> dirty_text;
+};
+
+// The editor's lines. A loaded document keeps the file mapped (or, for
+// streams, read into one buffer) and indexes only where each line starts; a
+// line gets a TextContainer the first time it is accessed through at() or
+// edit(). Lines that were only read can be rebuilt from the mapping, so once
+// they exceed LINE_TABLE_MEMORY_BUDGET the coldest of them are dropped again
+// (clock replacement). Edited and appended lines are dirty and stay resident.
+class LineTable {
+private:
+    const char* mapping;
+    size_t mapping_size;
+    bool mapped;   // mapping came from mmap rather than malloc
+    dev_t mapping_device;
+    ino_t mapping_inode;
+    // offsets[i] is where file line i starts; offsets[file_lines] is one past
+    // the last line's terminator, real or not.
+    uint64_t* offsets;
+    long long file_lines;
+
+    TextContainer** resident;
+    unsigned char* flags;
+    long long count;
+    long long capacity;
+    size_t clean_bytes;
+    long long clock_hand;
+
+    void grow(long long new_capacity) {
+        TextContainer** new_resident = new TextContainer*[new_capacity];
+        unsigned char* new_flags = new unsigned char[new_capacity];
+        for (long long i = 0; i < count; i++) {
+            new_resident[i] = resident[i];
+            new_flags[i] = flags[i];
+        }
+        for (long long i = count; i < new_capacity; i++) {
+            new_resident[i] = nullptr;
+            new_flags[i] = 0;
+        }
+        delete[] resident;
+        delete[] flags;
+        resident = new_resident;
+        flags = new_flags;
+        capacity = new_capacity;
+    }
+
+    void drop(long long line) {
+        if (resident[line] != nullptr && !(flags[line] & LINE_DIRTY)) {
+            clean_bytes -= (size_t)resident[line]->getCurrentSize() + 1;
+        }
+        delete resident[line];
+        resident[line] = nullptr;
+        flags[line] = 0;
+    }
+
+    void evictCold(long long keep) {
+        // Two sweeps: the first may only clear reference bits.
+        for (long long step = 0; step < 2 * count && clean_bytes > LINE_TABLE_MEMORY_BUDGET; step++) {
+            long long line = clock_hand;
+            clock_hand = (clock_hand + 1) % count;
+            if (line == keep || resident[line] == nullptr || (flags[line] & LINE_DIRTY)) {
+                continue;
+            }
+            if (flags[line] & LINE_REFERENCED) {
+                flags[line] &= ~LINE_REFERENCED;
+                continue;
+            }
+            drop(line);
+        }
+    }
+
+    TextContainer& materialize(long long line) {
+        if (resident[line] == nullptr) {
+            size_t length = 0;
+            const char* text = view(line, &length);
+            resident[line] = new TextContainer(text, (long long)length);
+            clean_bytes += length + 1;
+            flags[line] |= LINE_REFERENCED;
+            evictCold(line);
+        }
+        flags[line] |= LINE_REFERENCED;
+        return *resident[line];
+    }
+
+    void releaseSource() {
+        if (mapping != nullptr && mapped) {
+            munmap((void*)mapping, mapping_size);
+        } else {
+            free((void*)mapping);
+        }
+        delete[] offsets;
+        mapping = nullptr;
+        mapping_size = 0;
+        mapped = false;
+        mapping_device = 0;
+        mapping_inode = 0;
+        offsets = nullptr;
+        file_lines = 0;
+    }
+
+    // Builds offsets[] with lineScanIndex, which splits large files across
+    // all cores.
+    void indexLines() {
+        uint64_t newlines = 0;
+        offsets = lineScanIndex(mapping, mapping_size, 0, &newlines);
+        long long lines = (long long)newlines;
+        if (mapping_size > 0 && mapping[mapping_size - 1] != '\n') {
+            // The last line has no newline; pretend it has one past the end.
+            lines++;
+            offsets[lines] = mapping_size + 1;
+        }
+        file_lines = lines;
+        if (lines > capacity) {
+            grow(lines);
+        }
+        count = lines;
+    }
+
+public:
+    LineTable() {
+        mapping = nullptr;
+        mapping_size = 0;
+        mapped = false;
+        mapping_device = 0;
+        mapping_inode = 0;
+        offsets = nullptr;
+        file_lines = 0;
+        resident = nullptr;
+        flags = nullptr;
+        count = 0;
+        capacity = 0;
+        clean_bytes = 0;
+        clock_hand = 0;
+        grow(INITIAL_CAPACITY);
+    }
+
+    LineTable(const LineTable&) = delete;
+    LineTable& operator=(const LineTable&) = delete;
+
+    ~LineTable() {
+        clear();
+        delete[] resident;
+        delete[] flags;
+    }
+
+    long long size() const {
+        return count;
+    }
+
+    void clear() {
+        for (long long i = 0; i < count; i++) {
+            drop(i);
+        }
+        releaseSource();
+        count = 0;
+        clean_bytes = 0;
+        clock_hand = 0;
+    }
+
+    // Takes ownership of a read-only mapping of the file identified by info
+    // and indexes its lines.
+    void adoptMapping(const char* data, size_t size, const struct stat& info) {
+        clear();
+        mapping = data;
+        mapping_size = size;
+        mapped = true;
+        mapping_device = info.st_dev;
+        mapping_inode = info.st_ino;
+        indexLines();
+    }
+
+    // Same for text read into a malloc'd buffer, which the table frees.
+    void adoptBuffer(char* data, size_t size) {
+        clear();
+        mapping = data;
+        mapping_size = size;
+        indexLines();
+    }
+
+    // True if the document is backed by this very file, which must then not be
+    // truncated while the mapping is in use.
+    bool isBackedBy(const struct stat& info) const {
+        return mapping != nullptr && info.st_dev == mapping_device && info.st_ino == mapping_inode;
+    }
+
+    // Line text without materializing it: the resident copy if there is one,
+    // otherwise the bytes in the mapping. Not NUL-terminated.
+    const char* view(long long line, size_t* length) const {
+        if (resident[line] != nullptr) {
+            *length = (size_t)resident[line]->getCurrentSize();
+            return resident[line]->getBuffer();
+        }
+        if (line >= file_lines) {
+            *length = 0;
+            return "";
+        }
+        const char* text = mapping + offsets[line];
+        *length = (size_t)(offsets[line + 1] - offsets[line] - 1);
+        // A "\r\n" terminator is two bytes; a lone '\r' at end of file is text.
+        if (*length > 0 && text[*length - 1] == '\r' && offsets[line + 1] <= mapping_size) {
+            --*length;
+        }
+        return text;
+    }
+
+    // Materializes a line for reading. The reference stays valid until the
+    // next call that materializes a different line.
+    TextContainer& at(long long line) {
+        return materialize(line);
+    }
+
+    // Materializes a line for modification; it is never evicted after this.
+    TextContainer& edit(long long line) {
+        TextContainer& text = materialize(line);
+        if (!(flags[line] & LINE_DIRTY)) {
+            clean_bytes -= (size_t)text.getCurrentSize() + 1;
+            flags[line] |= LINE_DIRTY;
+        }
+        return text;
+    }
+
+    void append(const char* text) {
+        if (count >= capacity) {
+            grow(capacity * 2);
+        }
+        resident[count] = new TextContainer();
+        resident[count]->append(text);
+        flags[count] = LINE_DIRTY;
+        count++;
+    }
+
+    LineSnapshot* snapshot() const {
+        LineSnapshot* state = new LineSnapshot();
+        state->line_count = count;
+        long long dirty = 0;
+        for (long long i = 0; i < count; i++) {
+            dirty += (flags[i] & LINE_DIRTY) ? 1 : 0;
+        }
+        state->dirty_lines.reserve(dirty);
+        state->dirty_text.reserve(dirty);
+        for (long long i = 0; i < count; i++) {
+            if (flags[i] & LINE_DIRTY) {
+                state->dirty_lines.push_back(i);
+                state->dirty_text.push_back(*resident[i]);
+            }
+        }
+        return state;
+    }
+
+    // Puts the lines back as they were when `state` was taken. Clean resident
+    // lines are still valid and are kept.
+    void restore(const LineSnapshot& state) {
+        for (long long i = 0; i < count; i++) {
+            if ((flags[i] & LINE_DIRTY) || i >= state.line_count) {
+                drop(i);
+            }
+        }
+        if (state.line_count > capacity) {
+            grow(state.line_count);
+        }
+        for (size_t i = 0; i < state.dirty_lines.size(); i++) {
+            long long line = state.dirty_lines[i];
+            drop(line);
+            resident[line] = new TextContainer(state.dirty_text[i]);
+            flags[line] = LINE_DIRTY;
+        }
+        count = state.line_count;
+        if (clock_hand >= count) {
+            clock_hand = 0;
+        }
+    }
+};
+
+#endif // LINE_TABLE_H
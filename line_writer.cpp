@@ -0,0 +1,101 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include "line_writer.h"
+
+bool lineWriterInit(LineWriter* writer, int fd) {
+    writer->fd = fd;
+    writer->vector_count = 0;
+    writer->staged = 0;
+    writer->error = 0;
+    // Page-aligned so the kernel copies out of whole pages.
+    writer->staging = (char*)aligned_alloc(4096, LINE_WRITER_STAGING);
+    return writer->staging != nullptr;
+}
+
+void lineWriterDestroy(LineWriter* writer) {
+    free(writer->staging);
+    writer->staging = nullptr;
+}
+
+// Adjacent pieces (consecutive staged lines) share one iovec.
+static void appendVector(LineWriter* writer, const char* data, size_t length) {
+    if (writer->vector_count > 0) {
+        iovec& last = writer->vectors[writer->vector_count - 1];
+        if ((const char*)last.iov_base + last.iov_len == data) {
+            last.iov_len += length;
+            return;
+        }
+    }
+    writer->vectors[writer->vector_count].iov_base = (void*)data;
+    writer->vectors[writer->vector_count].iov_len = length;
+    writer->vector_count++;
+}
+
+bool lineWriterFlush(LineWriter* writer) {
+    if (writer->error != 0) {
+        errno = writer->error;
+        return false;
+    }
+    int first = 0;
+    while (first < writer->vector_count) {
+        ssize_t written = writev(writer->fd, writer->vectors + first, writer->vector_count - first);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            writer->error = errno;
+            writer->vector_count = 0;
+            writer->staged = 0;
+            return false;
+        }
+        // Skip what went out; a short write leaves the rest for the next call.
+        size_t remaining = (size_t)written;
+        while (remaining > 0) {
+            iovec& vector = writer->vectors[first];
+            if (remaining >= vector.iov_len) {
+                remaining -= vector.iov_len;
+                ++first;
+            } else {
+                vector.iov_base = (char*)vector.iov_base + remaining;
+                vector.iov_len -= remaining;
+                remaining = 0;
+            }
+        }
+    }
+    writer->vector_count = 0;
+    writer->staged = 0;
+    return true;
+}
+
+bool lineWriterAdd(LineWriter* writer, const char* line, size_t length) {
+    if (writer->error != 0) {
+        return false;
+    }
+    if (length < LINE_WRITER_COPY_LIMIT) {
+        if (writer->staged + length + 1 > LINE_WRITER_STAGING || writer->vector_count == LINE_WRITER_IOVECS) {
+            if (!lineWriterFlush(writer)) {
+                return false;
+            }
+        }
+        char* slot = writer->staging + writer->staged;
+        memcpy(slot, line, length);
+        slot[length] = '\n';
+        writer->staged += length + 1;
+        appendVector(writer, slot, length + 1);
+        return true;
+    }
+
+    if (writer->staged + 1 > LINE_WRITER_STAGING || writer->vector_count + 2 > LINE_WRITER_IOVECS) {
+        if (!lineWriterFlush(writer)) {
+            return false;
+        }
+    }
+    appendVector(writer, line, length);
+    char* newline = writer->staging + writer->staged;
+    *newline = '\n';
+    writer->staged += 1;
+    appendVector(writer, newline, 1);
+    return true;
+}
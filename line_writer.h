@@ -0,0 +1,40 @@
+#ifndef LINE_WRITER_H
+#define LINE_WRITER_H
+
+#include <cstddef>
+#include <sys/uio.h>
+
+// Writes a sequence of lines to a file descriptor with a few large writev
+// calls. Short lines are copied, newline included, into a staging buffer so
+// runs of them become one iovec; long lines are referenced in place and only
+// their newline is staged. Nothing is formatted and nothing goes through stdio.
+
+// IOV_MAX on Linux.
+#define LINE_WRITER_IOVECS 1024
+#define LINE_WRITER_STAGING (1u << 20)
+// Lines at least this long are referenced rather than copied.
+#define LINE_WRITER_COPY_LIMIT 4096
+
+struct LineWriter {
+    int fd;
+    iovec vectors[LINE_WRITER_IOVECS];
+    int vector_count;
+    char* staging;
+    size_t staged;
+    int error;   // errno of the first failed write, 0 while all is well
+};
+
+// Returns false if the staging buffer cannot be allocated.
+bool lineWriterInit(LineWriter* writer, int fd);
+
+// Queues `length` bytes of line followed by '\n'. A long line is referenced
+// rather than copied, so it must stay unchanged until the next flush. Returns
+// false once a write has failed.
+bool lineWriterAdd(LineWriter* writer, const char* line, size_t length);
+
+// Writes everything queued. Returns false with errno set on failure.
+bool lineWriterFlush(LineWriter* writer);
+
+void lineWriterDestroy(LineWriter* writer);
+
+#endif // LINE_WRITER_H
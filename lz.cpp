@@ -0,0 +1,183 @@
+#include <cstdint>
+#include <cstring>
+#include "lz.h"
+
+#define MIN_MATCH 4
+// The format requires the last literals to cover at least this many bytes...
+#define LAST_LITERALS 5
+// ...and the last match to start at least this far from the end.
+#define MATCH_FIND_LIMIT 12
+#define MAX_OFFSET 65535
+#define HASH_BITS 14
+
+static inline uint32_t read32(const unsigned char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t hashSequence(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static inline unsigned char* writeLength(unsigned char* op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (unsigned char)length;
+    return op;
+}
+
+size_t lzCompressBound(size_t length) {
+    return length + length / 255 + 16;
+}
+
+size_t lzCompress(const char* src, size_t length, char* dst, size_t dst_capacity) {
+    if (dst_capacity < lzCompressBound(length)) {
+        return 0;
+    }
+    const unsigned char* base = (const unsigned char*)src;
+    const unsigned char* ip = base;
+    const unsigned char* anchor = base;
+    const unsigned char* end = base + length;
+    unsigned char* op = (unsigned char*)dst;
+
+    if (length > MATCH_FIND_LIMIT) {
+        const unsigned char* find_limit = end - MATCH_FIND_LIMIT;
+        const unsigned char* match_limit = end - LAST_LITERALS;
+        uint32_t table[1 << HASH_BITS] = {};
+        unsigned int misses = 0;
+
+        while (ip < find_limit) {
+            uint32_t sequence = read32(ip);
+            uint32_t hash = hashSequence(sequence);
+            const unsigned char* ref = base + table[hash];
+            table[hash] = (uint32_t)(ip - base);
+
+            if (ref >= ip || ip - ref > MAX_OFFSET || read32(ref) != sequence) {
+                // Skip faster through data that does not compress.
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+
+            const unsigned char* match_end = ip + MIN_MATCH;
+            const unsigned char* ref_end = ref + MIN_MATCH;
+            while (match_end < match_limit && *match_end == *ref_end) {
+                ++match_end;
+                ++ref_end;
+            }
+
+            size_t literal_length = (size_t)(ip - anchor);
+            size_t match_length = (size_t)(match_end - ip) - MIN_MATCH;
+            unsigned char* token = op++;
+            *token = (unsigned char)((literal_length >= 15 ? 15 : literal_length) << 4);
+            if (literal_length >= 15) {
+                op = writeLength(op, literal_length - 15);
+            }
+            memcpy(op, anchor, literal_length);
+            op += literal_length;
+
+            size_t offset = (size_t)(ip - ref);
+            *op++ = (unsigned char)(offset & 0xFF);
+            *op++ = (unsigned char)(offset >> 8);
+
+            *token |= (unsigned char)(match_length >= 15 ? 15 : match_length);
+            if (match_length >= 15) {
+                op = writeLength(op, match_length - 15);
+            }
+
+            ip = match_end;
+            anchor = ip;
+            if (ip < find_limit) {
+                table[hashSequence(read32(ip - 2))] = (uint32_t)(ip - 2 - base);
+            }
+        }
+    }
+
+    size_t literal_length = (size_t)(end - anchor);
+    unsigned char* token = op++;
+    *token = (unsigned char)((literal_length >= 15 ? 15 : literal_length) << 4);
+    if (literal_length >= 15) {
+        op = writeLength(op, literal_length - 15);
+    }
+    if (literal_length > 0) {
+        memcpy(op, anchor, literal_length);
+        op += literal_length;
+    }
+
+    return (size_t)(op - (unsigned char*)dst);
+}
+
+long long lzDecompress(const char* src, size_t length, char* dst, size_t dst_capacity) {
+    const unsigned char* ip = (const unsigned char*)src;
+    const unsigned char* end = ip + length;
+    unsigned char* op = (unsigned char*)dst;
+    unsigned char* out_start = op;
+    unsigned char* out_end = op + dst_capacity;
+
+    while (ip < end) {
+        unsigned int token = *ip++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15) {
+            unsigned int extra;
+            do {
+                if (ip >= end) {
+                    return -1;
+                }
+                extra = *ip++;
+                literal_length += extra;
+            } while (extra == 255);
+        }
+        if (literal_length > (size_t)(end - ip) || literal_length > (size_t)(out_end - op)) {
+            return -1;
+        }
+        memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        // The last sequence carries literals only.
+        if (ip == end) {
+            break;
+        }
+
+        if (end - ip < 2) {
+            return -1;
+        }
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - out_start)) {
+            return -1;
+        }
+
+        size_t match_length = (token & 15);
+        if (match_length == 15) {
+            unsigned int extra;
+            do {
+                if (ip >= end) {
+                    return -1;
+                }
+                extra = *ip++;
+                match_length += extra;
+            } while (extra == 255);
+        }
+        match_length += MIN_MATCH;
+        if (match_length > (size_t)(out_end - op)) {
+            return -1;
+        }
+
+        const unsigned char* ref = op - offset;
+        if (offset >= match_length) {
+            memcpy(op, ref, match_length);
+            op += match_length;
+        } else {
+            // Overlapping copy repeats the last `offset` bytes.
+            for (size_t i = 0; i < match_length; ++i) {
+                *op++ = *ref++;
+            }
+        }
+    }
+    return (long long)(op - out_start);
+}
@@ -0,0 +1,22 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <cstddef>
+
+// Fast LZ77 block compression in the LZ4 block format: a token byte holds the
+// literal and match lengths, literals are copied verbatim, and matches are a
+// 16-bit back-reference. There is no entropy stage, so both directions run at
+// several hundred MB/s per core, faster than the disks the output goes to.
+
+// Worst-case compressed size for `length` input bytes.
+size_t lzCompressBound(size_t length);
+
+// Compresses src into dst. Returns the compressed size, or 0 if it does not
+// fit in dst_capacity.
+size_t lzCompress(const char* src, size_t length, char* dst, size_t dst_capacity);
+
+// Decompresses a block produced by lzCompress. Returns the decompressed size,
+// or -1 if the block is malformed or would overflow dst_capacity.
+long long lzDecompress(const char* src, size_t length, char* dst, size_t dst_capacity);
+
+#endif // LZ_H
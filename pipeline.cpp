@@ -0,0 +1,135 @@
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "io_util.h"
+#include "pipeline.h"
+
+struct PipelineSlot {
+    char* data;
+    size_t length;
+    bool last;
+};
+
+// Buffers move free -> filled -> transformed -> free. One lock covers all
+// three queues; each hand-off is per block, so contention is negligible.
+struct PipelineQueues {
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<PipelineSlot*> free_slots;
+    std::deque<PipelineSlot*> filled;
+    std::deque<PipelineSlot*> transformed;
+    bool stopping;
+    int read_errno;
+
+    PipelineSlot* pop(std::deque<PipelineSlot*>& queue) {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [&]() { return !queue.empty(); });
+        PipelineSlot* slot = queue.front();
+        queue.pop_front();
+        return slot;
+    }
+
+    void push(std::deque<PipelineSlot*>& queue, PipelineSlot* slot) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            queue.push_back(slot);
+        }
+        changed.notify_all();
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+
+    bool isStopping() {
+        std::lock_guard<std::mutex> guard(lock);
+        return stopping;
+    }
+};
+
+long long pipelineRun(int in_fd, int out_fd, PipelineTransform transform, void* context,
+                      size_t block_size, unsigned buffer_count) {
+    if (buffer_count < 2) {
+        buffer_count = 2;
+    }
+    std::vector<PipelineSlot> slots(buffer_count);
+    std::vector<char> storage(block_size * buffer_count);
+    PipelineQueues queues;
+    queues.stopping = false;
+    queues.read_errno = 0;
+    for (unsigned i = 0; i < buffer_count; ++i) {
+        slots[i].data = storage.data() + i * block_size;
+        queues.free_slots.push_back(&slots[i]);
+    }
+
+    // Reader: fills free buffers until EOF, a read error, or a writer failure.
+    // It always finishes by sending one slot marked last downstream, which is
+    // what lets the other two stages shut down.
+    std::thread reader([&]() {
+        while (true) {
+            PipelineSlot* slot = queues.pop(queues.free_slots);
+            ssize_t got = 0;
+            if (!queues.isStopping()) {
+                got = readFull(in_fd, slot->data, block_size);
+            }
+            if (got < 0) {
+                queues.read_errno = errno;
+            }
+            slot->length = got > 0 ? (size_t)got : 0;
+            slot->last = got <= 0 || (size_t)got < block_size;
+            queues.push(queues.filled, slot);
+            if (slot->last) {
+                return;
+            }
+        }
+    });
+
+    std::thread transformer([&]() {
+        while (true) {
+            PipelineSlot* slot = queues.pop(queues.filled);
+            if (slot->length > 0) {
+                transform(slot->data, slot->length, context);
+            }
+            queues.push(queues.transformed, slot);
+            if (slot->last) {
+                return;
+            }
+        }
+    });
+
+    // Writer runs on the calling thread.
+    long long written = 0;
+    int write_errno = 0;
+    while (true) {
+        PipelineSlot* slot = queues.pop(queues.transformed);
+        if (write_errno == 0 && slot->length > 0) {
+            if (writeAll(out_fd, slot->data, slot->length)) {
+                written += (long long)slot->length;
+            } else {
+                write_errno = errno;
+                queues.stop();
+            }
+        }
+        if (slot->last) {
+            break;
+        }
+        queues.push(queues.free_slots, slot);
+    }
+
+    // The writer keeps recycling buffers after a failure, so the reader always
+    // gets a slot to send its final marker in.
+    reader.join();
+    transformer.join();
+
+    if (write_errno != 0 || queues.read_errno != 0) {
+        errno = write_errno != 0 ? write_errno : queues.read_errno;
+        return -1;
+    }
+    return written;
+}
@@ -0,0 +1,23 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <cstddef>
+
+// File-to-file block pipeline with three stages, each on its own thread: read
+// a block, transform it, write it. A small ring of buffers circulates between
+// the stages, so reading block n+1, transforming block n and writing block n-1
+// overlap, and memory stays at buffer_count * block_size however large the
+// file is.
+
+#define PIPELINE_BLOCK_SIZE (4u << 20)
+#define PIPELINE_BUFFER_COUNT 3
+
+// Transforms `length` bytes in place.
+typedef void (*PipelineTransform)(char* block, size_t length, void* context);
+
+// Runs in_fd to EOF through the pipeline into out_fd. Returns the number of
+// bytes written, or -1 with errno set if a read or write failed.
+long long pipelineRun(int in_fd, int out_fd, PipelineTransform transform, void* context,
+                      size_t block_size, unsigned buffer_count);
+
+#endif // PIPELINE_H
@@ -0,0 +1,201 @@
+#ifndef TEXT_CONTAINER_H
+#define TEXT_CONTAINER_H
+
+#include <cstdio>
+#include <cstring>
+
+#define INITIAL_CAPACITY 100
+
+// A line kept as a gap buffer: the text is buffer[0, gap_start) followed by
+// buffer[gap_end, capacity), and the unused space sits between them. Edits
+// move the gap to their position first, so a run of edits at nearby indices
+// only shifts the bytes between consecutive edit points rather than the whole
+// tail each time. The gap is never empty, which leaves room for the NUL that
+// getBuffer() writes when it closes the gap.
+class TextContainer{
+private:
+    char* buffer; // for dynamic memory allocation
+    long long current_size;
+    long long capacity;
+    long long gap_start;
+    long long gap_end;
+
+
+    static void myStrcpy(char* dest, const char* src, long long length) { // копіює символи з одного рядка в інший
+        for (long long i = 0; i < length; i++) {
+            dest[i] = src[i];
+        }
+    }
+
+    long long tailLength() const {
+        return capacity - gap_end;
+    }
+
+    // Writes the text, without the gap, to dest.
+    void copyText(char* dest) const {
+        myStrcpy(dest, buffer, gap_start);
+        myStrcpy(dest + gap_start, buffer + gap_end, tailLength());
+    }
+
+    void moveGap(long long index) {
+        if (index < gap_start) {
+            long long moved = gap_start - index;
+            memmove(buffer + gap_end - moved, buffer + index, moved);
+            gap_start -= moved;
+            gap_end -= moved;
+        } else if (index > gap_start) {
+            long long moved = index - gap_start;
+            memmove(buffer + gap_start, buffer + gap_end, moved);
+            gap_start += moved;
+            gap_end += moved;
+        }
+    }
+
+    // Takes a copy of other's text with the gap closed at the end.
+    void copyContents(const TextContainer& other) {
+        current_size = other.current_size;
+        capacity = other.capacity;
+        buffer = new char[capacity];
+        other.copyText(buffer);
+        gap_start = current_size;
+        gap_end = capacity;
+        buffer[current_size] = '\0';
+    }
+
+    // Puts `length` bytes of text at the gap, which must already be in place.
+    void fillGap(const char* text, long long length) {
+        reserve(current_size + length + 1);
+        myStrcpy(buffer + gap_start, text, length);
+        gap_start += length;
+        current_size += length;
+    }
+
+public:
+    static long long myStrlen(const char* str) { // прописана функція, що визначає довжину рядка
+        long long len = 0;
+        while( str[len] != '\0') {
+            len++;
+        }
+        return len;
+    }
+
+    TextContainer() {
+        buffer = new char[INITIAL_CAPACITY];
+        buffer[0] = '\0';
+        current_size =0;
+        capacity = INITIAL_CAPACITY;
+        gap_start = 0;
+        gap_end = capacity;
+    }
+
+    // Holds exactly `length` bytes of text, which need not be NUL-terminated.
+    TextContainer(const char* text, long long length) {
+        buffer = new char[length + 1];
+        myStrcpy(buffer, text, length);
+        current_size = length;
+        capacity = length + 1;
+        gap_start = length;
+        gap_end = capacity;
+        buffer[current_size] = '\0';
+    }
+
+    TextContainer(const TextContainer& other) {
+        copyContents(other);
+    }
+
+    TextContainer& operator=(const TextContainer& other) { // функція перевантаження оператора, для правильного виділення пам'яті
+        if (this != &other) {
+            delete[] buffer;
+            copyContents(other);
+        }
+        return *this;
+    }
+
+    ~TextContainer() {
+        delete[] buffer;
+    }
+
+    // The gap stays where it was; the new space is added to it.
+    void resize(long long new_capacity) {
+        char* new_buffer = new char[new_capacity];
+        long long tail = tailLength();
+        myStrcpy(new_buffer, buffer, gap_start);
+        myStrcpy(new_buffer + new_capacity - tail, buffer + gap_end, tail);
+        delete[] buffer;
+        buffer = new_buffer;
+        capacity = new_capacity;
+        gap_end = new_capacity - tail;
+    }
+
+    // Growth at least doubles the buffer, so a line built from many small
+    // edits is copied O(log n) times rather than once per edit.
+    void reserve(long long needed) {
+        if (needed > capacity) {
+            resize(needed > capacity * 2 ? needed : capacity * 2);
+        }
+    }
+
+    void append(const char* text_to_append) {
+        moveGap(current_size);
+        fillGap(text_to_append, myStrlen(text_to_append));
+    }
+
+    // Contiguous, NUL-terminated text. Closes the gap by moving it to the end,
+    // which costs nothing if it is already there.
+    char* getBuffer() {
+        moveGap(current_size);
+        buffer[current_size] = '\0';
+        return buffer;
+    }
+
+    long long getCurrentSize() const {
+        return current_size;
+    }
+
+    void insert(long long index, const char* text_to_insert) {
+        if (index < 0 || index > current_size) {
+            printf("Error: Invalid index.\n");
+            return;
+        }
+        moveGap(index);
+        fillGap(text_to_insert, myStrlen(text_to_insert));
+    }
+
+    void deleteText(long long index, long long count) {
+        if (index < 0 || index >= current_size || count <= 0) {
+            printf("Error: Invalid index or count.\n");
+            return;
+        }
+        if (index + count > current_size) {
+            count = current_size - index;
+        }
+        // The deleted bytes just become part of the gap.
+        moveGap(index);
+        gap_end += count;
+        current_size -= count;
+    }
+
+    void insertReplacement(long long index, const char* text_to_insert) {
+        long long insert_length = myStrlen(text_to_insert);
+        if (index < 0 || index >= current_size) {
+            printf("Error: Invalid index.\n");
+            return;
+        }
+        // Overwriting is deleting what gets covered and inserting in its place.
+        long long covered = current_size - index < insert_length ? current_size - index : insert_length;
+        moveGap(index);
+        gap_end += covered;
+        current_size -= covered;
+        fillGap(text_to_insert, insert_length);
+    }
+
+    void copyFrom(const TextContainer& other) {
+        if (this != &other) {
+            delete[] buffer;
+            copyContents(other);
+        }
+    }
+
+};
+
+#endif // TEXT_CONTAINER_H
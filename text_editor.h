@@ -0,0 +1,1252 @@
+#ifndef TEXT_EDITOR_H
+#define TEXT_EDITOR_H
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stack>
+#include <vector>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "batch.h"
+#include "caesar.h"
+#include "caesar_kernels.h"
+#include "cipher_plugin.h"
+#include "container.h"
+#include "io_util.h"
+#include "line_table.h"
+#include "line_writer.h"
+#include "text_container.h"
+#include "uring_io.h"
+
+#define EXIT_COMMAND 19
+#define LAST_COMMAND 25
+
+#define CIPHER_PLUGIN_PATH "./libcrypt.so"
+
+// One loaded cipher build. The library stays mapped until the last reference
+// is dropped, so a call that started on it always finishes on it.
+struct CipherPlugin {
+    void* handle;
+    const CipherVTable* vtable;
+
+    CipherPlugin(void* plugin_handle, const CipherVTable* table) {
+        handle = plugin_handle;
+        vtable = table;
+    }
+
+    CipherPlugin(const CipherPlugin&) = delete;
+    CipherPlugin& operator=(const CipherPlugin&) = delete;
+
+    ~CipherPlugin() {
+        if (handle) {
+            dlclose(handle);
+        }
+    }
+};
+
+// Front end for the cipher. It dispatches through the vtable of the plugin at
+// CIPHER_PLUGIN_PATH when one with a compatible ABI is present and falls back
+// to the statically linked kernels otherwise. The plugin can be swapped while
+// the editor runs; see reload().
+class Caesar {
+private:
+    std::shared_ptr<CipherPlugin> plugin;
+
+    static bool isCompatible(const CipherVTable* table) {
+        return table != nullptr
+            && table->abi_version == CIPHER_ABI_VERSION
+            && table->struct_size >= sizeof(CipherVTable)
+            && table->encrypt != nullptr
+            && table->decrypt != nullptr;
+    }
+
+    // dlopen returns the already-loaded image for a path it has seen before,
+    // and overwriting a mapped library in place corrupts the running code.
+    // Loading from a private copy avoids both.
+    static char* copyToTemporary(const char* path) {
+        int in_fd = open(path, O_RDONLY);
+        if (in_fd < 0) {
+            return nullptr;
+        }
+        char* temp_path = strdup("/tmp/libcrypt-XXXXXX");
+        int out_fd = mkstemp(temp_path);
+        if (out_fd < 0) {
+            close(in_fd);
+            free(temp_path);
+            return nullptr;
+        }
+        char buffer[64 * 1024];
+        ssize_t got = 0;
+        bool ok = true;
+        while (ok && (got = readFull(in_fd, buffer, sizeof(buffer))) > 0) {
+            ok = writeAll(out_fd, buffer, (size_t)got);
+        }
+        close(in_fd);
+        ok = close(out_fd) == 0 && ok;
+        if (!ok || got < 0) {
+            unlink(temp_path);
+            free(temp_path);
+            return nullptr;
+        }
+        return temp_path;
+    }
+
+    static std::shared_ptr<CipherPlugin> openPlugin(const char* path) {
+        char* temp_path = copyToTemporary(path);
+        if (temp_path == nullptr) {
+            fprintf(stderr, "Error: unable to read %s\n", path);
+            return nullptr;
+        }
+        // RTLD_NOW resolves everything up front, so a broken build is rejected
+        // here instead of failing in the middle of a call after the swap.
+        void* handle = dlopen(temp_path, RTLD_NOW | RTLD_LOCAL);
+        unlink(temp_path);
+        free(temp_path);
+        if (!handle) {
+            fprintf(stderr, "Error: %s\n", dlerror());
+            return nullptr;
+        }
+
+        GetCipherVTableFunc getVTable = (GetCipherVTableFunc)dlsym(handle, CIPHER_VTABLE_SYMBOL);
+        const CipherVTable* table = getVTable ? getVTable() : nullptr;
+        if (!isCompatible(table)) {
+            fprintf(stderr, "Error: %s does not provide cipher ABI version %d\n", path, CIPHER_ABI_VERSION);
+            dlclose(handle);
+            return nullptr;
+        }
+        return std::make_shared<CipherPlugin>(handle, table);
+    }
+
+    std::shared_ptr<CipherPlugin> acquire() const {
+        return std::atomic_load(&plugin);
+    }
+
+public:
+    Caesar() {
+        plugin = std::make_shared<CipherPlugin>(nullptr, get_cipher_vtable());
+        if (access(CIPHER_PLUGIN_PATH, F_OK) != 0) {
+            return;
+        }
+        std::shared_ptr<CipherPlugin> loaded = openPlugin(CIPHER_PLUGIN_PATH);
+        if (loaded) {
+            plugin = loaded;
+        }
+    }
+
+    // Loads the build at `path` and, if its ABI checks out, atomically makes it
+    // the table every new call dispatches through. Calls already running keep
+    // their reference to the old table, which is dlclosed after the last one
+    // returns. On failure the current table stays in place.
+    bool reload(const char* path) {
+        std::shared_ptr<CipherPlugin> loaded = openPlugin(path);
+        if (!loaded) {
+            return false;
+        }
+        std::atomic_store(&plugin, loaded);
+        return true;
+    }
+
+    void describe() const {
+        std::shared_ptr<CipherPlugin> current = acquire();
+        const CipherVTable* table = current->vtable;
+        static const char* simd_names[] = {"scalar", "SSE2", "AVX2"};
+        printf(">Cipher '%s' (%s), ABI %u, SIMD %s, alignment %u, capabilities:%s%s%s\n",
+               table->name ? table->name : "unnamed",
+               current->handle ? "plugin" : "built-in",
+               table->abi_version,
+               table->simd_level <= CIPHER_SIMD_AVX2 ? simd_names[table->simd_level] : "unknown",
+               table->preferred_alignment,
+               (table->capabilities & CIPHER_CAP_IN_PLACE) ? " in-place" : "",
+               (table->capabilities & CIPHER_CAP_BATCH) ? " batch" : "",
+               (table->capabilities & CIPHER_CAP_REKEY) ? " rekey" : "");
+    }
+
+    // Short texts use the key-specialized kernels inline when no plugin is
+    // loaded; a call through the table costs more than shifting a line.
+    char* encrypt_text(const char* text, int key) {
+        std::shared_ptr<CipherPlugin> current = acquire();
+        size_t length = strlen(text);
+        char* encryptedText = new char[length + 1];
+        if (current->handle) {
+            current->vtable->encrypt(text, encryptedText, length, key);
+        } else {
+            encryptInline(text, encryptedText, length, key);
+        }
+        encryptedText[length] = '\0';
+        return encryptedText;
+    }
+
+    char* decrypt_text(const char* text, int key) {
+        std::shared_ptr<CipherPlugin> current = acquire();
+        size_t length = strlen(text);
+        char* decryptedText = new char[length + 1];
+        if (current->handle) {
+            current->vtable->decrypt(text, decryptedText, length, key);
+        } else {
+            decryptInline(text, decryptedText, length, key);
+        }
+        decryptedText[length] = '\0';
+        return decryptedText;
+    }
+
+    enum FileOperation { FILE_ENCRYPT, FILE_DECRYPT, FILE_REKEY };
+
+    // One file operation with the cipher table pinned for its whole run, so a
+    // reload part-way through a file cannot leave two ciphers in one output.
+    struct FileCipher {
+        std::shared_ptr<CipherPlugin> plugin;
+        FileOperation operation;
+        int key;       // the old key when re-keying
+        int new_key;   // FILE_REKEY only
+    };
+
+    FileCipher fileCipher(FileOperation operation, int key, int new_key = 0) const {
+        return FileCipher{acquire(), operation, key, new_key};
+    }
+
+    // PipelineTransform over a FileCipher, used by the file backends. Blocks
+    // are large, so they always go through the table, whose built-in entries
+    // are the CPUID-dispatched SIMD kernels. A plugin that cannot work in place
+    // gets a private copy of the block as its source.
+    static void transformBlock(char* block, size_t length, void* context) {
+        const FileCipher* cipher = (const FileCipher*)context;
+        const CipherVTable* table = cipher->plugin->vtable;
+        std::unique_ptr<char[]> source;
+        const char* src = block;
+        if (!(table->capabilities & CIPHER_CAP_IN_PLACE)) {
+            source.reset(new char[length]);
+            memcpy(source.get(), block, length);
+            src = source.get();
+        }
+        if (cipher->operation == FILE_ENCRYPT) {
+            table->encrypt(src, block, length, cipher->key);
+        } else if (cipher->operation == FILE_DECRYPT) {
+            table->decrypt(src, block, length, cipher->key);
+        } else if ((table->capabilities & CIPHER_CAP_REKEY) && table->rekey) {
+            table->rekey(src, block, length, cipher->key, cipher->new_key);
+        } else {
+            // Without a rekey entry point the plaintext exists only in this
+            // block, between the two calls.
+            table->decrypt(src, block, length, cipher->key);
+            if (src != block) {
+                memcpy(source.get(), block, length);
+            }
+            table->encrypt(src, block, length, cipher->new_key);
+        }
+    }
+
+    int crack_file(const char* filename, CaesarKeyScore* ranked) {
+        return caesarCrackFile(filename, CAESAR_CRACK_SAMPLE, ranked);
+    }
+};
+
+class TextEditor {
+private:
+    Caesar* caesar;
+    LineTable lines;
+    char* clipboard;
+    std::stack<LineSnapshot*> undo_stack;
+    std::stack<LineSnapshot*> redo_stack;
+
+    static void clearStack(std::stack<LineSnapshot*>& stack) {
+        while (!stack.empty()) {
+            delete stack.top();
+            stack.pop();
+        }
+    }
+
+    void freeMemory() {
+        lines.clear();
+        if (clipboard != nullptr) {
+            delete[] clipboard;
+            clipboard = nullptr;
+        }
+        clearStack(undo_stack);
+        clearStack(redo_stack);
+    }
+
+    // Snapshots hold only the lines that differ from the loaded file, so an
+    // edit to a large, mostly untouched document copies little.
+    void saveState() {
+        undo_stack.push(lines.snapshot());
+    }
+
+    void clearRedoStack() {
+        clearStack(redo_stack);
+    }
+
+    void pushToUndoStack() {
+        undo_stack.push(lines.snapshot());
+    }
+
+    void pushToRedoStack() {
+        redo_stack.push(lines.snapshot());
+    }
+
+public:
+    TextEditor()  {
+        caesar = new Caesar();
+        clipboard = nullptr;
+    }
+
+    ~TextEditor() {
+        freeMemory();
+        delete caesar;
+    }
+
+    static void printHelp(){
+        printf("Commands: \n");
+        printf("1 - append <text> - append text to the end \n");
+        printf("2 - start the new line \n");
+        printf("3 - save <filename> - use files to save the information \n");
+        printf("4 - load <filename> - use files to load the information \n");
+        printf("5 - print the current text to console \n");
+        printf("6 - insert the text by line and symbol index \n");
+        printf("7 - search <word> \n");
+        printf("8 - delete symbol by line and index \n");
+        printf("9 - insert text with replacemenet \n");
+        printf("10 - cut text by line and index \n");
+        printf("11 - copy text by line and index \n");
+        printf("12 - paste text by line and index \n");
+        printf("13 - undo \n");
+        printf("14 - redo \n");
+        printf("15 - encrypt file \n");
+        printf("16 - decrypt file\n");
+        printf("17 - encrypt text\n");
+        printf("18 - decrypt text\n");
+        printf("19 - exit the program\n");
+        printf("20 - crack encrypted file (guess the key)\n");
+        printf("21 - re-encrypt file with a new key\n");
+        printf("22 - reload cipher plugin\n");
+        printf("23 - load line range from encrypted container\n");
+        printf("24 - verify encrypted container\n");
+        printf("25 - batch encrypt/decrypt a directory or manifest\n");
+    }
+
+    void init() {
+        lines.clear();
+    }
+
+    void appendText(const char* text_to_append) {
+        saveState();
+        lines.append(text_to_append);
+    }
+
+    void saveToFile(const char* filename) {
+        // Unedited lines are read from the mapping of the loaded file, so saving
+        // over that file goes through a temporary and a rename; truncating it in
+        // place would pull the text out from under the mapping.
+        struct stat target;
+        char* temporary = nullptr;
+        int fd;
+        if (stat(filename, &target) == 0 && lines.isBackedBy(target)) {
+            fd = openReplacement(filename, target.st_mode, &temporary);
+        } else {
+            fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        }
+        if (fd < 0) {
+            printf(">Unable to open file for writing.\n");
+            return;
+        }
+        LineWriter writer;
+        if (!lineWriterInit(&writer, fd)) {
+            close(fd);
+            if (temporary != nullptr) {
+                finishReplacement(temporary, filename, false);
+            }
+            printf(">Unable to open file for writing.\n");
+            return;
+        }
+        bool ok = true;
+        for (long long i = 0; i < lines.size() && ok; i++) {
+            size_t length = 0;
+            const char* text = lines.view(i, &length);
+            ok = lineWriterAdd(&writer, text, length);
+        }
+        ok = lineWriterFlush(&writer) && ok;
+        lineWriterDestroy(&writer);
+        ok = close(fd) == 0 && ok;
+        if (temporary != nullptr) {
+            ok = finishReplacement(temporary, filename, ok);
+        }
+        if (!ok) {
+            printf(">Unable to write file.\n");
+            return;
+        }
+        printf(">Text has been saved successfully");
+    }
+
+    // Replaces the document with text held in a malloc'd buffer, which the
+    // line table takes over.
+    void adoptText(char* text, size_t length) {
+        freeMemory();
+        lines.adoptBuffer(text, length);
+    }
+
+    // Maps the file read-only and indexes where its lines start; no line is
+    // copied until it is used. Returns false when the file cannot be mapped
+    // (pipes, special files), so the caller can fall back to reading it.
+    bool loadFromMapping(const char* filename) {
+        int fd = open(filename, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        // Empty files go through the stream path too, which also covers /proc
+        // files that report a size of zero.
+        if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+            close(fd);
+            return false;
+        }
+        size_t size = (size_t)info.st_size;
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+
+        freeMemory();
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        lines.adoptMapping((const char*)mapping, size, info);
+        // Later accesses jump around the file.
+        madvise(mapping, size, MADV_NORMAL);
+        return true;
+    }
+
+    void loadFromFile(const char* filename) {
+        if (loadFromMapping(filename)) {
+            printText();
+            return;
+        }
+        // Pipes and other streams are read whole into one buffer and indexed
+        // the same way as a mapping.
+        int fd = open(filename, O_RDONLY);
+        if (fd < 0) {
+            printf(">Unable to open file for reading.\n");
+            return;
+        }
+        size_t size = 0;
+        size_t allocated = 64 * 1024;
+        char* text = (char*)malloc(allocated);
+        ssize_t got = 0;
+        while (text != nullptr && (got = readFull(fd, text + size, allocated - size)) > 0) {
+            size += (size_t)got;
+            if (size == allocated) {
+                allocated *= 2;
+                char* bigger = (char*)realloc(text, allocated);
+                if (bigger == nullptr) {
+                    free(text);
+                }
+                text = bigger;
+            }
+        }
+        close(fd);
+        if (text == nullptr || got < 0) {
+            free(text);
+            printf(">Unable to read file.\n");
+            return;
+        }
+        adoptText(text, size);
+        printText();
+    }
+
+    // Read-only walks use views, so printing or searching a large document
+    // does not materialize its lines.
+    void printText() {
+        if (lines.size() == 0) {
+            printf(">Text container is empty.\n");
+            return;
+        }
+        printf(">Current text:\n");
+        for (long long i = 0; i < lines.size(); i++) {
+            size_t length = 0;
+            const char* text = lines.view(i, &length);
+            fwrite(text, 1, length, stdout);
+            putchar('\n');
+        }
+    }
+
+    void insertText(long long line, long long index,const char* text_to_insert) {
+        if ( line >= lines.size() || line < 0) {
+            printf("Error: Invalid line number. \n");
+            return;
+        }
+        saveState();
+        lines.edit(line).insert(index, text_to_insert);
+    }
+
+    void search_word(char* word) {
+        long long found_count = 0;
+        long long word_length = 0;
+        while (word[word_length] != '\0') {
+            word_length++;
+        }
+        for (long long i = 0; i < lines.size() && word_length > 0; i++) {
+            size_t length = 0;
+            const char* buffer = lines.view(i, &length);
+            const char* end = buffer + length;
+            const char* found = buffer;
+            while (found < end) {
+                const char* temp = found;
+                long long j = 0;
+                while (temp + j < end && temp[j] == word[j] && word[j] != '\0') {
+                    j++;
+                }
+                if (j == word_length) {
+                    long long word_index = found - buffer;
+                    printf(">Found '%s' at line %lld, index %lld\n", word, i, word_index);
+                    found += j;
+                    found_count++;
+                } else {
+                    found++;
+                }
+            }
+        }
+        if (found_count == 0) {
+            printf(">Word '%s' not found.\n", word);
+        }
+    }
+
+    void deleteText(long long line, long long index, long long count) {
+        if (line >= lines.size() || line < 0) {
+            printf("Error: Invalid line number.\n");
+            return;
+        }
+        saveState();
+        lines.edit(line).deleteText(index, count);
+    }
+
+    void insertReplacement(long long line, long long index, const char* text_to_replace) {
+
+        if (line >= lines.size() || line < 0) {
+            printf("Error: Invalid line number.\n");
+            return;
+        }
+        saveState();
+        lines.edit(line).insertReplacement(index, text_to_replace);
+    }
+
+    void cutText(long long line, long long index, long long count) {
+        if (line >= lines.size() || line < 0) {
+            printf("Error: Invalid line number.\n");
+            return;
+        }
+        TextContainer& text = lines.at(line);
+        char* buffer = text.getBuffer();
+        if (index < 0 || index >= text.getCurrentSize() || count <= 0) {
+            printf("Error: Invalid index or count.\n");
+            return;
+        }
+        if (index + count > text.getCurrentSize()) {
+            count = text.getCurrentSize() - index;
+        }
+        delete[] clipboard;
+        clipboard = new char[count + 1];
+        for (long long i = 0; i < count; i++) {
+            clipboard[i] = buffer[index + i];
+        }
+        clipboard[count] = '\0';
+        saveState();
+        lines.edit(line).deleteText(index, count);
+    }
+
+    void copyText(long long line, long long index, long long count) {
+
+        if (line >= lines.size() || line < 0) {
+            printf("Error: Invalid line number.\n");
+            return;
+        }
+        TextContainer& text = lines.at(line);
+        char* buffer = text.getBuffer();
+        if (index < 0 || index >= text.getCurrentSize() || count <= 0) {
+            printf("Error: Invalid index or count.\n");
+            return;
+        }
+        if (index + count > text.getCurrentSize()) {
+            count = text.getCurrentSize() - index;
+        }
+        delete[] clipboard;
+        clipboard = new char[count + 1];
+        for (long long i = 0; i < count; i++) {
+            clipboard[i] = buffer[index + i];
+        }
+        clipboard[count] = '\0';
+    }
+
+    void pasteText(long long line, long long index) {
+
+        if (line >= lines.size() || line < 0) {
+            printf("Error: Invalid line number.\n");
+            return;
+        }
+        if (clipboard == nullptr) {
+            printf("Clipboard is empty.\n");
+            return;
+        }
+        if (index < 0 || index > lines.at(line).getCurrentSize()) {
+            printf("Error: Invalid index.\n");
+            return;
+        }
+        saveState();
+        lines.edit(line).insert(index, clipboard);
+    }
+
+    void undo() {
+        if (undo_stack.empty()) {
+            printf("No steps to undo.\n");
+            return;
+        }
+
+        pushToRedoStack();
+
+        LineSnapshot* previous_state = undo_stack.top();
+        undo_stack.pop();
+
+        lines.restore(*previous_state);
+        delete previous_state;
+
+        printf("Undo successful. Restored to the previous state.\n");
+    }
+
+    void redo() {
+        if (redo_stack.empty()) {
+            printf("No steps to redo.\n");
+            return;
+        }
+
+        pushToUndoStack();
+
+        LineSnapshot* state_to_redo = redo_stack.top();
+        redo_stack.pop();
+
+        lines.restore(*state_to_redo);
+        delete state_to_redo;
+
+        printf("Redo successful. Restored to the previous state.\n");
+    }
+
+    // Every command that writes a file must not truncate the one the document
+    // is mapped from: the next access to an unedited line would fault. Such
+    // output is written to a temporary, stored in *temporary, which
+    // finishOutput() later renames over the file. Returns the path to write
+    // to, or nullptr with errno set if the temporary cannot be created.
+    const char* redirectOutput(const char* filename, char** temporary) {
+        *temporary = nullptr;
+        struct stat target;
+        if (stat(filename, &target) != 0 || !lines.isBackedBy(target)) {
+            return filename;
+        }
+        int fd = openReplacement(filename, target.st_mode, temporary);
+        if (fd < 0) {
+            return nullptr;
+        }
+        close(fd);
+        return *temporary;
+    }
+
+    // Completes a redirectOutput(): renames the temporary over filename if ok,
+    // removes it otherwise. Returns ok, or false with errno set if the rename
+    // fails.
+    static bool finishOutput(char* temporary, const char* filename, bool ok) {
+        if (temporary == nullptr) {
+            return ok;
+        }
+        return finishReplacement(temporary, filename, ok);
+    }
+
+    // Runs one file through the io_uring backend (blocking pipeline on kernels
+    // without it) with the current cipher. Returns bytes written or -1.
+    long long transformFile(const char* inputFilename, const char* outputFilename, const Caesar::FileCipher& cipher) {
+        char* temporary;
+        const char* target = redirectOutput(outputFilename, &temporary);
+        if (target == nullptr) {
+            return -1;
+        }
+        FileTransformJob job = {inputFilename, target, Caesar::transformBlock, (void*)&cipher, 0, 0, 0};
+        uringTransformFiles(&job, 1, 0);
+        bool replaced = finishOutput(temporary, outputFilename, job.error == 0);
+        if (job.error != 0) {
+            errno = job.error;
+            return -1;
+        }
+        return replaced ? job.written : -1;
+    }
+
+    // With use_container the output is written in the chunk-indexed container
+    // format (container.h) straight from the input file, which allows later
+    // random-access reads of line ranges. compress adds an LZ stage before the
+    // shift and only applies to containers.
+    void encryptFile(const char* inputFilename, const char* outputFilename, int key, bool use_container = false, bool compress = false) {
+        if (use_container) {
+            uint32_t flags = compress ? CONTAINER_FLAG_COMPRESSED : 0;
+            char* temporary;
+            const char* target = redirectOutput(outputFilename, &temporary);
+            bool ok = target != nullptr
+                && containerEncryptFile(inputFilename, target, key, CONTAINER_DEFAULT_CHUNK, flags) == 0;
+            if (target == nullptr || !finishOutput(temporary, outputFilename, ok)) {
+                printf(">Unable to encrypt file into a container.\n");
+                return;
+            }
+            printf(">Text has been saved successfully");
+            return;
+        }
+        // Plain output streams file to file; the open document is not touched.
+        if (transformFile(inputFilename, outputFilename, caesar->fileCipher(Caesar::FILE_ENCRYPT, key)) < 0) {
+            printf(">Unable to encrypt file: %s\n", strerror(errno));
+            return;
+        }
+        printf(">Text has been saved successfully");
+    }
+
+    void decryptFile(const char* inputFilename, const char* outputFilename, int key) {
+        if (containerIsFile(inputFilename)) {
+            uint64_t bad_chunk = 0;
+            char* temporary;
+            const char* target = redirectOutput(outputFilename, &temporary);
+            int status = target != nullptr ? containerDecryptFile(inputFilename, target, key, &bad_chunk)
+                                           : CONTAINER_ERROR_IO;
+            if (target != nullptr && !finishOutput(temporary, outputFilename, status == 0)) {
+                status = CONTAINER_ERROR_IO;
+            }
+            if (status == CONTAINER_ERROR_CORRUPT) {
+                printf(">Chunk %llu is corrupted; decryption stopped there.\n", (unsigned long long)bad_chunk);
+                return;
+            }
+            if (status != 0) {
+                printf(">Unable to decrypt container.\n");
+                return;
+            }
+            printf(">Text has been saved successfully");
+            return;
+        }
+        if (transformFile(inputFilename, outputFilename, caesar->fileCipher(Caesar::FILE_DECRYPT, key)) < 0) {
+            printf(">Unable to decrypt file: %s\n", strerror(errno));
+            return;
+        }
+        printf(">Text has been saved successfully");
+    }
+
+    void crackFile(const char* filename) {
+        CaesarKeyScore ranked[26];
+        if (caesar->crack_file(filename, ranked) != 0) {
+            printf(">Unable to open file for reading.\n");
+            return;
+        }
+        printf(">Most likely keys:\n");
+        for (int i = 0; i < 5; i++) {
+            printf("  key %2d  (score %.1f)\n", ranked[i].key, ranked[i].score);
+        }
+    }
+
+    // Moves an encrypted file from old_key to new_key in one streaming pass,
+    // without loading it into the editor or writing plaintext anywhere.
+    void rekeyFile(const char* inputFilename, const char* outputFilename, int old_key, int new_key) {
+        Caesar::FileCipher cipher = caesar->fileCipher(Caesar::FILE_REKEY, old_key, new_key);
+        long long written = transformFile(inputFilename, outputFilename, cipher);
+        if (written < 0) {
+            printf(">Re-encryption failed: %s\n", strerror(errno));
+            return;
+        }
+        printf(">Re-encrypted %lld bytes", written);
+    }
+
+    // Replaces the document with lines [first_line, first_line + count) of an
+    // encrypted container, decrypting only the chunks that cover them.
+    void loadContainerLines(const char* filename, int key, long long first_line, long long count) {
+        if (first_line < 0 || count <= 0) {
+            printf("Error: Invalid line range.\n");
+            return;
+        }
+        CipherContainer container;
+        if (containerOpen(&container, filename) != 0) {
+            printf(">Unable to open encrypted container.\n");
+            return;
+        }
+        size_t length = 0;
+        char* text = containerReadLines(&container, key, first_line, count, &length);
+        printf(">Container holds %llu lines.\n", (unsigned long long)container.line_count);
+        containerClose(&container);
+        if (text == nullptr) {
+            printf(">Unable to read encrypted container (I/O error or corrupted chunk).\n");
+            return;
+        }
+
+        adoptText(text, length);
+        printText();
+    }
+
+    void verifyFile(const char* filename) {
+        uint64_t bad_chunk = 0;
+        int status = containerVerifyFile(filename, &bad_chunk);
+        if (status == CONTAINER_ERROR_CORRUPT) {
+            printf(">Chunk %llu failed its integrity check.\n", (unsigned long long)bad_chunk);
+        } else if (status != 0) {
+            printf(">Unable to read encrypted container.\n");
+        } else {
+            printf(">All chunks are intact.\n");
+        }
+    }
+
+    // Runs every file of a directory tree (mirrored under output_dir) or of a
+    // manifest (output_dir unused) through the file engine in one call, then
+    // reports per-file and overall throughput.
+    void batchFiles(const char* source, const char* output_dir, int key, bool decrypting) {
+        BatchEntry* entries = nullptr;
+        size_t count = 0;
+        struct stat info;
+        if (stat(source, &info) == 0 && S_ISDIR(info.st_mode)) {
+            if (batchScanDirectory(source, output_dir, key, &entries, &count) != 0) {
+                printf(">Unable to scan directory: %s\n", strerror(errno));
+                return;
+            }
+        } else {
+            size_t bad_line = 0;
+            if (batchLoadManifest(source, &entries, &count, &bad_line) != 0) {
+                if (bad_line > 0) {
+                    printf(">Manifest line %zu is not \"input output key\".\n", bad_line);
+                } else {
+                    printf(">Unable to read manifest.\n");
+                }
+                return;
+            }
+        }
+
+        // Every file runs through the same engine and cipher as a single one.
+        std::vector<Caesar::FileCipher> ciphers;
+        std::vector<FileTransformJob> jobs(count);
+        std::vector<char*> temporaries(count, nullptr);
+        ciphers.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            const char* target = redirectOutput(entries[i].output_path, &temporaries[i]);
+            if (target == nullptr) {
+                printf(">%s: unable to create a temporary (%s)\n", entries[i].output_path, strerror(errno));
+                for (size_t j = 0; j < i; ++j) {
+                    finishOutput(temporaries[j], entries[j].output_path, false);
+                }
+                batchFreeEntries(entries, count);
+                return;
+            }
+            ciphers.push_back(caesar->fileCipher(decrypting ? Caesar::FILE_DECRYPT : Caesar::FILE_ENCRYPT, entries[i].key));
+            jobs[i] = {entries[i].input_path, target, Caesar::transformBlock, &ciphers[i], 0, 0, 0};
+        }
+        auto start = std::chrono::steady_clock::now();
+        size_t failures = uringTransformFiles(jobs.data(), count, 0);
+        for (size_t i = 0; i < count; ++i) {
+            if (!finishOutput(temporaries[i], entries[i].output_path, jobs[i].error == 0) && jobs[i].error == 0) {
+                jobs[i].error = errno;
+                jobs[i].written = -1;
+                failures++;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        unsigned long long total = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const FileTransformJob& job = jobs[i];
+            if (job.error != 0) {
+                printf(">%s: failed (%s)\n", job.input_path, strerror(job.error));
+                continue;
+            }
+            total += (unsigned long long)job.written;
+            double rate = job.seconds > 0 ? job.written / job.seconds / 1e6 : 0;
+            printf(">%s: %lld bytes in %.3f s (%.1f MB/s)\n", job.input_path, job.written, job.seconds, rate);
+        }
+        printf(">%zu files, %llu bytes in %.3f s (%.1f MB/s), %zu failed",
+               count, total, seconds, seconds > 0 ? total / seconds / 1e6 : 0, failures);
+
+        batchFreeEntries(entries, count);
+    }
+
+    void handleCommand(int command) {
+        char* input = nullptr;
+        size_t input_size = 0;
+        if (command == 1) {
+            printf("Enter text to append: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            appendText(input);
+            free(input);
+        }
+        else if (command == 2) {
+            appendText("");
+        }
+        else if (command == 3) {
+            printf("Enter filename to save: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            saveToFile(input);
+            free(input);
+        } else if (command == 4) {
+            printf("Enter filename to load: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            loadFromFile(input);
+            free(input);
+        }
+        else if (command == 5) {
+            printText();
+        } else if (command == 6) {
+            printf("Enter line number: ");
+            long long line;
+            scanf("%lld", &line);
+            printf("Enter index: ");
+            long long index;
+            scanf("%lld", &index);
+            getchar();
+            printf("Enter text to insert: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            insertText(line, index, input);
+            free(input);
+        } else if (command == 7) {
+            printf("Enter word to search: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            search_word(input);
+            free(input);
+        }
+        else if (command == 8) {
+            printf("Enter line number: ");
+            long long line;
+            scanf("%lld", &line);
+            printf("Enter start index: ");
+            long long index;
+            scanf("%lld", &index);
+            printf("Enter number of characters to delete: ");
+            long long count;
+            scanf("%lld", &count);
+            deleteText(line, index, count);
+        }
+        else if (command == 9) {
+            printf("Enter line number: ");
+            long long line;
+            scanf("%lld", &line);
+            printf("Enter index: ");
+            long long index;
+            scanf("%lld", &index);
+            getchar();
+            printf("Enter text to insert with replacement: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            insertReplacement(line, index, input);
+            free(input);
+        }
+        else if (command == 10) {
+            printf("Enter line number: ");
+            long long line;
+            scanf("%lld", &line);
+            printf("Enter start index: ");
+            long long index;
+            scanf("%lld", &index);
+            printf("Enter number of characters to cut: ");
+            long long count;
+            scanf("%lld", &count);
+            cutText(line, index, count);
+        }
+        else if (command == 11) {
+            printf("Enter line number: ");
+            long long line;
+            scanf("%lld", &line);
+            printf("Enter start index: ");
+            long long index;
+            scanf("%lld", &index);
+            printf("Enter number of characters to copy: ");
+            long long count;
+            scanf("%lld", &count);
+            copyText(line, index, count);
+        }
+        else if (command == 12) {
+            printf("Enter line number: ");
+            long long line;
+            scanf("%lld", &line);
+            printf("Enter index: ");
+            long long index;
+            scanf("%lld", &index);
+            getchar();
+            pasteText(line, index);
+        }
+        else if (command == 13) {
+            undo();
+        }
+        else if (command == 14) {
+            redo();
+        }
+        else if (command == 15) {
+            printf("Enter input filename to encrypt: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            char* inputFilename = strdup(input);
+
+            printf("Enter output filename: ");
+            getline(&input, &input_size, stdin);
+            len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            char* outputFilename = strdup(input);
+
+            printf("Enter encryption key: ");
+            int key;
+            scanf("%d", &key);
+            getchar();  // Clear the newline character
+
+            printf("Use indexed container format? (y/n): ");
+            getline(&input, &input_size, stdin);
+            bool use_container = input[0] == 'y' || input[0] == 'Y';
+            bool compress = false;
+            if (use_container) {
+                printf("Compress before encrypting? (y/n): ");
+                getline(&input, &input_size, stdin);
+                compress = input[0] == 'y' || input[0] == 'Y';
+            }
+
+            encryptFile(inputFilename, outputFilename, key, use_container, compress);
+
+            free(inputFilename);
+            free(outputFilename);
+        }
+        else if (command == 16) {
+            printf("Enter input filename to decrypt: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            char* inputFilename = strdup(input);
+
+            printf("Enter output filename: ");
+            getline(&input, &input_size, stdin);
+            len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            char* outputFilename = strdup(input);
+
+            printf("Enter decryption key: ");
+            int key;
+            scanf("%d", &key);
+            getchar();
+
+            decryptFile(inputFilename, outputFilename, key);
+
+            free(inputFilename);
+            free(outputFilename);
+        }
+        else if (command == 17) {
+            printf("Enter text to encrypt: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+
+            printf("Enter encryption key: ");
+            int key;
+            scanf("%d", &key);
+            getchar();  // Clear the newline character
+
+            char* encryptedText = caesar->encrypt_text(input, key);
+            printf("Encrypted text: %s\n", encryptedText);
+            delete[] encryptedText;
+        }
+        else if (command == 18) {
+            printf("Enter text to decrypt: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+
+            printf("Enter encryption key: ");
+            int key;
+            scanf("%d", &key);
+            getchar();  // Clear the newline character
+
+            char* decryptedText = caesar->decrypt_text(input, key);
+            printf("Encrypted text: %s\n", decryptedText);
+            delete[] decryptedText;
+        }
+        else if (command == 19) {
+            freeMemory();
+            exit(0);
+        }
+        else if (command == 20) {
+            printf("Enter filename to crack: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            crackFile(input);
+            free(input);
+        }
+        else if (command == 21) {
+            printf("Enter input filename to re-encrypt: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            char* inputFilename = strdup(input);
+
+            printf("Enter output filename: ");
+            getline(&input, &input_size, stdin);
+            len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            char* outputFilename = strdup(input);
+
+            printf("Enter current key: ");
+            int old_key;
+            scanf("%d", &old_key);
+            printf("Enter new key: ");
+            int new_key;
+            scanf("%d", &new_key);
+            getchar();  // Clear the newline character
+
+            rekeyFile(inputFilename, outputFilename, old_key, new_key);
+
+            free(inputFilename);
+            free(outputFilename);
+            free(input);
+        }
+        else if (command == 22) {
+            printf("Enter plugin path (empty for %s): ", CIPHER_PLUGIN_PATH);
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            if (caesar->reload(len > 0 ? input : CIPHER_PLUGIN_PATH)) {
+                printf(">Cipher plugin reloaded.\n");
+            } else {
+                printf(">Reload failed, keeping the current cipher.\n");
+            }
+            caesar->describe();
+            free(input);
+        }
+        else if (command == 23) {
+            printf("Enter container filename: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+
+            printf("Enter decryption key: ");
+            int key;
+            scanf("%d", &key);
+            printf("Enter first line: ");
+            long long first_line;
+            scanf("%lld", &first_line);
+            printf("Enter number of lines: ");
+            long long count;
+            scanf("%lld", &count);
+            getchar();  // Clear the newline character
+
+            loadContainerLines(input, key, first_line, count);
+            free(input);
+        }
+        else if (command == 24) {
+            printf("Enter container filename to verify: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            verifyFile(input);
+            free(input);
+        }
+        else if (command == 25) {
+            printf("Enter directory or manifest file: ");
+            getline(&input, &input_size, stdin);
+            size_t len = 0;
+            while (input[len] != '\n' && input[len] != '\0') {
+                len++;
+            }
+            input[len] = '\0';
+            char* source = strdup(input);
+
+            // A manifest carries its own outputs and keys.
+            struct stat info;
+            char* outputDir = nullptr;
+            int key = 0;
+            if (stat(source, &info) == 0 && S_ISDIR(info.st_mode)) {
+                printf("Enter output directory: ");
+                getline(&input, &input_size, stdin);
+                len = 0;
+                while (input[len] != '\n' && input[len] != '\0') {
+                    len++;
+                }
+                input[len] = '\0';
+                outputDir = strdup(input);
+
+                printf("Enter key: ");
+                scanf("%d", &key);
+                getchar();  // Clear the newline character
+            }
+
+            printf("Decrypt instead of encrypt? (y/n): ");
+            getline(&input, &input_size, stdin);
+            bool decrypting = input[0] == 'y' || input[0] == 'Y';
+
+            batchFiles(source, outputDir, key, decrypting);
+
+            free(source);
+            free(outputDir);
+            free(input);
+        }
+        else {
+            printf("The command is not implemented.\n");
+        }
+    }
+};
+
+#endif // TEXT_EDITOR_H
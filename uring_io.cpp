@@ -0,0 +1,763 @@
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "io_util.h"
+#include "pipeline.h"
+#include "uring_io.h"
+
+// Raw io_uring: there is no liburing dependency, just the three syscalls and
+// the shared submission/completion rings they map.
+struct UringRing {
+    int fd;
+    unsigned sq_entries;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    io_uring_sqe* sqes;
+    io_uring_cqe* cqes;
+    void* sq_map;
+    size_t sq_map_size;
+    void* cq_map;
+    size_t cq_map_size;
+    size_t sqes_size;
+    unsigned queued;   // prepared but not yet handed to the kernel
+};
+
+static void ringTeardown(UringRing* ring) {
+    if (ring->sqes != nullptr) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_map != nullptr && ring->cq_map != ring->sq_map) {
+        munmap(ring->cq_map, ring->cq_map_size);
+    }
+    if (ring->sq_map != nullptr) {
+        munmap(ring->sq_map, ring->sq_map_size);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+}
+
+static void* mapRing(int fd, size_t size, off_t offset) {
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return map == MAP_FAILED ? nullptr : map;
+}
+
+static int ringSetup(UringRing* ring, unsigned entries) {
+    memset(ring, 0, sizeof(*ring));
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        return -1;
+    }
+    ring->sq_entries = params.sq_entries;
+    ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_map) {
+        if (ring->cq_map_size > ring->sq_map_size) {
+            ring->sq_map_size = ring->cq_map_size;
+        }
+        ring->cq_map_size = ring->sq_map_size;
+    }
+
+    ring->sq_map = mapRing(ring->fd, ring->sq_map_size, IORING_OFF_SQ_RING);
+    if (ring->sq_map != nullptr) {
+        ring->cq_map = single_map ? ring->sq_map : mapRing(ring->fd, ring->cq_map_size, IORING_OFF_CQ_RING);
+    }
+    ring->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    if (ring->cq_map != nullptr) {
+        ring->sqes = (io_uring_sqe*)mapRing(ring->fd, ring->sqes_size, IORING_OFF_SQES);
+    }
+    if (ring->sqes == nullptr) {
+        int saved = errno;
+        ringTeardown(ring);
+        errno = saved;
+        return -1;
+    }
+
+    char* sq = (char*)ring->sq_map;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    char* cq = (char*)ring->cq_map;
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+    return 0;
+}
+
+// Hands queued submissions to the kernel and, if wait_for > 0, blocks until at
+// least that many completions are available. One syscall does both.
+static int ringEnter(UringRing* ring, unsigned wait_for) {
+    while (true) {
+        long submitted = syscall(__NR_io_uring_enter, ring->fd, ring->queued, wait_for,
+                                 wait_for > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (submitted >= 0) {
+            ring->queued -= (unsigned)submitted;
+            return 0;
+        }
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+}
+
+static io_uring_sqe* ringNextSqe(UringRing* ring) {
+    unsigned tail = *ring->sq_tail;
+    if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries) {
+        if (ringEnter(ring, 0) != 0) {
+            return nullptr;
+        }
+        if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries) {
+            return nullptr;
+        }
+    }
+    io_uring_sqe* sqe = &ring->sqes[tail & *ring->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+// Publishes the entry returned by the last ringNextSqe call.
+static void ringCommit(UringRing* ring) {
+    unsigned tail = *ring->sq_tail;
+    unsigned index = tail & *ring->sq_mask;
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->queued++;
+}
+
+// One job while it is open; both engines track its progress here.
+struct UringFile {
+    FileTransformJob* job;
+    int in_fd;
+    int out_fd;
+    char* temporary;   // replacement being written when output == input
+    uint64_t size;
+    uint64_t next_offset;
+    long long written;
+    unsigned in_flight;
+    int error;
+    std::chrono::steady_clock::time_point opened;
+};
+
+static bool fileDone(const UringFile* file) {
+    return file->in_flight == 0 && (file->error != 0 || file->next_offset >= file->size);
+}
+
+// Opens the job's input and output; failures are left in file->error. Returns
+// true if the input is a pipe or device, which has no size to split into
+// blocks and must be run through runStream() instead.
+static bool openFile(UringFile* file, FileTransformJob* job) {
+    file->job = job;
+    file->opened = std::chrono::steady_clock::now();
+    file->in_fd = open(job->input_path, O_RDONLY);
+    file->out_fd = -1;
+    file->temporary = nullptr;
+    file->size = 0;
+    file->next_offset = 0;
+    file->written = 0;
+    file->in_flight = 0;
+    file->error = 0;
+    struct stat info;
+    if (file->in_fd < 0 || fstat(file->in_fd, &info) != 0) {
+        file->error = errno;
+        return false;
+    }
+    // Truncating the output when it is the input would destroy the data
+    // before it is read, so that case writes a replacement and renames it.
+    if (isSameFile(info, job->output_path)) {
+        file->out_fd = openReplacement(job->output_path, info.st_mode, &file->temporary);
+    } else {
+        file->out_fd = open(job->output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if (file->out_fd < 0) {
+        file->error = errno;
+        return false;
+    }
+    posix_fadvise(file->in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (!S_ISREG(info.st_mode)) {
+        return true;
+    }
+    file->size = (uint64_t)info.st_size;
+    return false;
+}
+
+static void runStream(UringFile* file) {
+    long long written = pipelineRun(file->in_fd, file->out_fd, file->job->transform, file->job->context,
+                                    PIPELINE_BLOCK_SIZE, PIPELINE_BUFFER_COUNT);
+    if (written < 0) {
+        file->error = errno;
+    } else {
+        file->written = written;
+    }
+}
+
+// Closes the job's files and stores its result. Returns true if it failed.
+static bool closeFile(UringFile* file) {
+    if (file->in_fd >= 0) {
+        close(file->in_fd);
+    }
+    if (file->out_fd >= 0 && close(file->out_fd) != 0 && file->error == 0) {
+        file->error = errno;
+    }
+    if (file->temporary != nullptr && !finishReplacement(file->temporary, file->job->output_path, file->error == 0)
+        && file->error == 0) {
+        file->error = errno;
+    }
+    file->temporary = nullptr;
+    file->job->error = file->error;
+    file->job->written = file->error != 0 ? -1 : file->written;
+    file->job->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - file->opened).count();
+    file->job = nullptr;
+    return file->error != 0;
+}
+
+// ---- io_uring engine ----
+
+// A buffer carries one block of one file: read it, transform it in place,
+// write it back out at the same offset. Short transfers are resubmitted for
+// the rest.
+struct UringBuffer {
+    char* data;
+    UringFile* file;
+    uint64_t offset;
+    uint32_t length;
+    uint32_t done;
+    bool writing;
+};
+
+// user_data of the read kept posted on the workers' eventfd.
+#define URING_WAKE_TAG (~(uint64_t)0)
+
+struct UringEngine {
+    UringRing ring;
+    bool registered;
+    UringBuffer buffers[URING_BUFFER_COUNT];
+    std::vector<unsigned> free_buffers;
+    UringFile files[URING_MAX_OPEN_JOBS];
+    unsigned in_flight;
+    size_t finished;
+    size_t failures;
+
+    // Transform workers. Without them blocks are transformed on the ring
+    // thread between completions.
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable work_ready;
+    std::deque<unsigned> to_transform;
+    std::vector<unsigned> transformed;
+    bool stopping;
+    // Workers signal finished blocks on an eventfd, and the ring thread keeps
+    // a read posted on it, so one io_uring_enter waits for both kinds of event.
+    int wake_fd;
+    uint64_t* wake_value;
+    bool wake_posted;
+};
+
+static bool submitBuffer(UringEngine* engine, unsigned index) {
+    UringBuffer* buffer = &engine->buffers[index];
+    io_uring_sqe* sqe = ringNextSqe(&engine->ring);
+    if (sqe == nullptr) {
+        return false;
+    }
+    if (buffer->writing) {
+        sqe->opcode = engine->registered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        sqe->fd = buffer->file->out_fd;
+    } else {
+        sqe->opcode = engine->registered ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe->fd = buffer->file->in_fd;
+    }
+    sqe->addr = (uint64_t)(uintptr_t)(buffer->data + buffer->done);
+    sqe->len = buffer->length - buffer->done;
+    sqe->off = buffer->offset + buffer->done;
+    sqe->buf_index = (uint16_t)index;
+    sqe->user_data = index;
+    ringCommit(&engine->ring);
+    return true;
+}
+
+static bool postWakeRead(UringEngine* engine) {
+    io_uring_sqe* sqe = ringNextSqe(&engine->ring);
+    if (sqe == nullptr) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = engine->wake_fd;
+    sqe->addr = (uint64_t)(uintptr_t)engine->wake_value;
+    sqe->len = sizeof(uint64_t);
+    sqe->off = ~(uint64_t)0;
+    sqe->user_data = URING_WAKE_TAG;
+    ringCommit(&engine->ring);
+    engine->wake_posted = true;
+    return true;
+}
+
+static void retireFile(UringEngine* engine, UringFile* file) {
+    engine->failures += closeFile(file) ? 1 : 0;
+    engine->finished++;
+}
+
+static void startFile(UringEngine* engine, UringFile* file, FileTransformJob* job) {
+    if (openFile(file, job)) {
+        runStream(file);
+    }
+    if (fileDone(file)) {
+        retireFile(engine, file);
+    }
+}
+
+static void releaseBuffer(UringEngine* engine, unsigned index) {
+    UringFile* file = engine->buffers[index].file;
+    engine->free_buffers.push_back(index);
+    engine->in_flight--;
+    file->in_flight--;
+    if (fileDone(file)) {
+        retireFile(engine, file);
+    }
+}
+
+static void startWrite(UringEngine* engine, unsigned index) {
+    UringBuffer* buffer = &engine->buffers[index];
+    buffer->writing = true;
+    buffer->done = 0;
+    if (!submitBuffer(engine, index)) {
+        buffer->file->error = EIO;
+        releaseBuffer(engine, index);
+    }
+}
+
+static void transformWorker(UringEngine* engine) {
+    std::unique_lock<std::mutex> guard(engine->lock);
+    while (true) {
+        engine->work_ready.wait(guard, [&]() { return engine->stopping || !engine->to_transform.empty(); });
+        if (engine->to_transform.empty()) {
+            return;
+        }
+        unsigned index = engine->to_transform.front();
+        engine->to_transform.pop_front();
+        guard.unlock();
+        UringBuffer* buffer = &engine->buffers[index];
+        const FileTransformJob* job = buffer->file->job;
+        job->transform(buffer->data, buffer->length, job->context);
+        guard.lock();
+        engine->transformed.push_back(index);
+        if (engine->transformed.size() == 1) {
+            // The ring thread drains the whole list per wakeup, so only the
+            // first block after a drain needs to signal.
+            uint64_t one = 1;
+            ssize_t ignored = write(engine->wake_fd, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+}
+
+static void collectTransformed(UringEngine* engine) {
+    std::vector<unsigned> ready;
+    {
+        std::lock_guard<std::mutex> guard(engine->lock);
+        ready.swap(engine->transformed);
+    }
+    for (unsigned index : ready) {
+        if (engine->buffers[index].file->error != 0) {
+            releaseBuffer(engine, index);
+        } else {
+            startWrite(engine, index);
+        }
+    }
+}
+
+static void stopWorkers(UringEngine* engine) {
+    {
+        std::lock_guard<std::mutex> guard(engine->lock);
+        engine->stopping = true;
+    }
+    engine->work_ready.notify_all();
+    for (std::thread& worker : engine->workers) {
+        worker.join();
+    }
+    engine->workers.clear();
+}
+
+static void completeBuffer(UringEngine* engine, unsigned index, int result) {
+    UringBuffer* buffer = &engine->buffers[index];
+    UringFile* file = buffer->file;
+    if (result == -EINTR || result == -EAGAIN) {
+        if (!submitBuffer(engine, index)) {
+            file->error = EIO;
+            releaseBuffer(engine, index);
+        }
+        return;
+    }
+    if (result < 0) {
+        file->error = -result;
+        releaseBuffer(engine, index);
+        return;
+    }
+
+    if (!buffer->writing) {
+        if (result == 0) {
+            // The input shrank since fstat; write what did arrive.
+            buffer->length = buffer->done;
+            if (file->size > buffer->offset + buffer->done) {
+                file->size = buffer->offset + buffer->done;
+            }
+        } else {
+            buffer->done += (uint32_t)result;
+        }
+        if (buffer->done < buffer->length) {
+            if (!submitBuffer(engine, index)) {
+                file->error = EIO;
+                releaseBuffer(engine, index);
+            }
+            return;
+        }
+        if (buffer->length == 0 || file->error != 0) {
+            releaseBuffer(engine, index);
+            return;
+        }
+        if (!engine->workers.empty()) {
+            {
+                std::lock_guard<std::mutex> guard(engine->lock);
+                engine->to_transform.push_back(index);
+            }
+            engine->work_ready.notify_one();
+            return;
+        }
+        file->job->transform(buffer->data, buffer->length, file->job->context);
+        startWrite(engine, index);
+        return;
+    }
+
+    if (result == 0) {
+        file->error = EIO;
+        releaseBuffer(engine, index);
+        return;
+    }
+    buffer->done += (uint32_t)result;
+    if (buffer->done < buffer->length) {
+        if (!submitBuffer(engine, index)) {
+            file->error = EIO;
+            releaseBuffer(engine, index);
+        }
+        return;
+    }
+    file->written += buffer->length;
+    releaseBuffer(engine, index);
+}
+
+// Deals free buffers out one per open file per pass, so every open file has
+// reads in flight rather than the first one taking the whole pool.
+static void startReads(UringEngine* engine) {
+    bool handed = true;
+    while (handed && !engine->free_buffers.empty()) {
+        handed = false;
+        for (unsigned slot = 0; slot < URING_MAX_OPEN_JOBS && !engine->free_buffers.empty(); ++slot) {
+            UringFile* file = &engine->files[slot];
+            if (file->job == nullptr || file->error != 0 || file->next_offset >= file->size) {
+                continue;
+            }
+            unsigned index = engine->free_buffers.back();
+            engine->free_buffers.pop_back();
+            UringBuffer* buffer = &engine->buffers[index];
+            uint64_t remaining = file->size - file->next_offset;
+            buffer->file = file;
+            buffer->offset = file->next_offset;
+            buffer->length = remaining < URING_BUFFER_SIZE ? (uint32_t)remaining : URING_BUFFER_SIZE;
+            buffer->done = 0;
+            buffer->writing = false;
+            file->next_offset += buffer->length;
+            file->in_flight++;
+            engine->in_flight++;
+            if (!submitBuffer(engine, index)) {
+                file->error = EIO;
+                releaseBuffer(engine, index);
+                continue;
+            }
+            handed = true;
+        }
+    }
+}
+
+// Handles everything in the completion queue. Blocks the workers have
+// finished are picked up once the wake read has come back.
+static void reapCompletions(UringEngine* engine) {
+    UringRing* ring = &engine->ring;
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    bool woken = false;
+    while (head != tail) {
+        io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+        uint64_t tag = cqe->user_data;
+        int result = cqe->res;
+        ++head;
+        if (tag == URING_WAKE_TAG) {
+            engine->wake_posted = false;
+            woken = true;
+        } else {
+            completeBuffer(engine, (unsigned)tag, result);
+        }
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    if (woken) {
+        collectTransformed(engine);
+    }
+}
+
+// ---- blocking engine ----
+
+// Without io_uring, worker threads share the open files and each claims one
+// block at a time: pread it, transform it, pwrite it. Everything but the I/O
+// and the transform happens under one lock.
+struct BlockingEngine {
+    std::mutex lock;
+    std::condition_variable changed;
+    UringFile files[URING_MAX_OPEN_JOBS];
+    FileTransformJob* jobs;
+    size_t count;
+    size_t next_job;
+    size_t finished;
+    size_t failures;
+};
+
+static void blockingRetire(BlockingEngine* engine, UringFile* file) {
+    engine->failures += closeFile(file) ? 1 : 0;
+    engine->finished++;
+    engine->changed.notify_all();
+}
+
+static void blockingWorker(BlockingEngine* engine) {
+    std::vector<char> buffer(URING_BUFFER_SIZE);
+    std::unique_lock<std::mutex> guard(engine->lock);
+    while (engine->finished < engine->count) {
+        UringFile* file = nullptr;
+        UringFile* free_slot = nullptr;
+        for (unsigned slot = 0; slot < URING_MAX_OPEN_JOBS; ++slot) {
+            UringFile* candidate = &engine->files[slot];
+            if (candidate->job == nullptr) {
+                free_slot = free_slot != nullptr ? free_slot : candidate;
+            } else if (candidate->error == 0 && candidate->next_offset < candidate->size) {
+                file = candidate;
+                break;
+            }
+        }
+        if (file == nullptr) {
+            if (free_slot == nullptr || engine->next_job == engine->count) {
+                // Everything left is being worked on by other threads.
+                engine->changed.wait(guard);
+                continue;
+            }
+            if (openFile(free_slot, &engine->jobs[engine->next_job++])) {
+                free_slot->in_flight = 1;
+                guard.unlock();
+                runStream(free_slot);
+                guard.lock();
+                free_slot->in_flight = 0;
+            }
+            if (fileDone(free_slot)) {
+                blockingRetire(engine, free_slot);
+            }
+            continue;
+        }
+
+        uint64_t offset = file->next_offset;
+        uint64_t remaining = file->size - offset;
+        size_t length = remaining < URING_BUFFER_SIZE ? (size_t)remaining : URING_BUFFER_SIZE;
+        file->next_offset += length;
+        file->in_flight++;
+        guard.unlock();
+
+        int error = 0;
+        ssize_t got = preadFull(file->in_fd, buffer.data(), length, (off_t)offset);
+        if (got < 0) {
+            error = errno;
+        } else if (got > 0) {
+            file->job->transform(buffer.data(), (size_t)got, file->job->context);
+            if (!pwriteAll(file->out_fd, buffer.data(), (size_t)got, (off_t)offset)) {
+                error = errno;
+            }
+        }
+
+        guard.lock();
+        file->in_flight--;
+        if (error != 0) {
+            if (file->error == 0) {
+                file->error = error;
+            }
+        } else {
+            file->written += got;
+            if ((size_t)got < length && file->size > offset + (uint64_t)got) {
+                // The input shrank since fstat.
+                file->size = offset + (uint64_t)got;
+            }
+        }
+        if (fileDone(file)) {
+            blockingRetire(engine, file);
+        }
+    }
+}
+
+static size_t blockingTransformFiles(FileTransformJob* jobs, size_t count, unsigned threads) {
+    BlockingEngine engine;
+    for (unsigned slot = 0; slot < URING_MAX_OPEN_JOBS; ++slot) {
+        engine.files[slot].job = nullptr;
+    }
+    engine.jobs = jobs;
+    engine.count = count;
+    engine.next_job = 0;
+    engine.finished = 0;
+    engine.failures = 0;
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i) {
+        pool.emplace_back(blockingWorker, &engine);
+    }
+    blockingWorker(&engine);
+    for (std::thread& t : pool) {
+        t.join();
+    }
+    return engine.failures;
+}
+
+size_t uringTransformFiles(FileTransformJob* jobs, size_t count, unsigned threads) {
+    if (count == 0) {
+        return 0;
+    }
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+    UringEngine* engine = new UringEngine;
+    if (ringSetup(&engine->ring, URING_QUEUE_DEPTH) != 0) {
+        // ENOSYS on kernels without io_uring, EPERM where it is disabled by
+        // sysctl or seccomp.
+        delete engine;
+        return blockingTransformFiles(jobs, count, threads);
+    }
+
+    // The eventfd read target lives with the buffers, so it is leaked along
+    // with them if the ring has to be abandoned.
+    size_t storage_size = (size_t)URING_BUFFER_COUNT * URING_BUFFER_SIZE;
+    char* storage = (char*)aligned_alloc(4096, storage_size + 4096);
+    if (storage == nullptr) {
+        ringTeardown(&engine->ring);
+        delete engine;
+        for (size_t i = 0; i < count; ++i) {
+            jobs[i].written = -1;
+            jobs[i].error = ENOMEM;
+        }
+        return count;
+    }
+    iovec vectors[URING_BUFFER_COUNT];
+    for (unsigned i = 0; i < URING_BUFFER_COUNT; ++i) {
+        engine->buffers[i].data = storage + (size_t)i * URING_BUFFER_SIZE;
+        vectors[i].iov_base = engine->buffers[i].data;
+        vectors[i].iov_len = URING_BUFFER_SIZE;
+        engine->free_buffers.push_back(URING_BUFFER_COUNT - 1 - i);
+    }
+    // Registered buffers are pinned once instead of on every request. When
+    // that is refused (usually RLIMIT_MEMLOCK), plain READ/WRITE still work.
+    engine->registered = syscall(__NR_io_uring_register, engine->ring.fd, IORING_REGISTER_BUFFERS,
+                                 vectors, URING_BUFFER_COUNT) == 0;
+    for (unsigned slot = 0; slot < URING_MAX_OPEN_JOBS; ++slot) {
+        engine->files[slot].job = nullptr;
+    }
+    engine->in_flight = 0;
+    engine->finished = 0;
+    engine->failures = 0;
+    engine->stopping = false;
+    engine->wake_value = (uint64_t*)(storage + storage_size);
+    engine->wake_posted = false;
+
+    // One transform worker per thread; more than one per buffer would idle.
+    // On a single thread they would only add hand-off latency.
+    unsigned worker_count = threads < URING_BUFFER_COUNT ? threads : URING_BUFFER_COUNT;
+    engine->wake_fd = worker_count > 1 ? eventfd(0, EFD_CLOEXEC) : -1;
+    if (engine->wake_fd >= 0) {
+        for (unsigned i = 0; i < worker_count; ++i) {
+            engine->workers.emplace_back(transformWorker, engine);
+        }
+    }
+
+    size_t next_job = 0;
+    bool abandoned = false;
+    while (engine->finished < count) {
+        for (unsigned slot = 0; slot < URING_MAX_OPEN_JOBS && next_job < count; ++slot) {
+            if (engine->files[slot].job == nullptr) {
+                startFile(engine, &engine->files[slot], &jobs[next_job++]);
+            }
+        }
+        startReads(engine);
+        if (engine->in_flight == 0) {
+            continue;
+        }
+
+        bool waiting = engine->workers.empty() || engine->wake_posted || postWakeRead(engine);
+        if (!waiting || ringEnter(&engine->ring, 1) != 0) {
+            // Cannot happen with a healthy ring; fail what is still open.
+            int error = waiting ? errno : EIO;
+            stopWorkers(engine);
+            for (unsigned slot = 0; slot < URING_MAX_OPEN_JOBS; ++slot) {
+                if (engine->files[slot].job != nullptr) {
+                    engine->files[slot].error = error;
+                    retireFile(engine, &engine->files[slot]);
+                }
+            }
+            for (size_t i = next_job; i < count; ++i) {
+                jobs[i].written = -1;
+                jobs[i].error = error;
+                engine->failures++;
+            }
+            abandoned = true;
+            break;
+        }
+        reapCompletions(engine);
+    }
+
+    stopWorkers(engine);
+    if (!abandoned && engine->wake_posted) {
+        // Complete the outstanding wake read before its target is freed.
+        uint64_t one = 1;
+        ssize_t ignored = write(engine->wake_fd, &one, sizeof(one));
+        (void)ignored;
+        while (engine->wake_posted && ringEnter(&engine->ring, 1) == 0) {
+            reapCompletions(engine);
+        }
+    }
+    if (engine->wake_fd >= 0) {
+        close(engine->wake_fd);
+    }
+    size_t failures = engine->failures;
+    ringTeardown(&engine->ring);
+    if (!abandoned && !engine->wake_posted) {
+        // After an abandoned ring the kernel may still complete reads into
+        // these buffers, so they are leaked rather than reused.
+        free(storage);
+    }
+    delete engine;
+    return failures;
+}
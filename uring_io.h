@@ -0,0 +1,42 @@
+#ifndef URING_IO_H
+#define URING_IO_H
+
+#include <cstddef>
+#include "pipeline.h"
+
+// Asynchronous bulk file transforms on io_uring. One ring serves every job:
+// reads from several input files and writes to their outputs are kept in
+// flight together in a pool of registered buffers, and each io_uring_enter
+// call submits everything queued and collects whatever has completed. Completed
+// reads are handed to a pool of transform workers, so one large file keeps
+// every core busy; the ring thread itself only does I/O.
+//
+// Kernels without io_uring (or where it is disabled) get the same scheduling
+// on plain threads, each doing pread/transform/pwrite one block at a time.
+// Pipes and devices go through the blocking pipeline from pipeline.h.
+
+#define URING_QUEUE_DEPTH 32
+#define URING_BUFFER_COUNT 16
+// 16 x 256 KiB stays under the default 8 MiB RLIMIT_MEMLOCK that registered
+// buffers are charged against.
+#define URING_BUFFER_SIZE (256u * 1024)
+#define URING_MAX_OPEN_JOBS 8
+
+struct FileTransformJob {
+    const char* input_path;
+    const char* output_path;
+    PipelineTransform transform;   // applied in place to every block
+    void* context;
+    long long written;    // out: bytes written, or -1 on failure
+    int error;            // out: errno of the failure, 0 on success
+    double seconds;       // out: from opening the files to closing them
+};
+
+// Transforms every job's input into its output on `threads` workers (0 = one
+// per hardware thread); the transform must tolerate concurrent calls on
+// different blocks. An output that is the input itself is written to a
+// temporary and renamed into place. Fills in written/error for each job and
+// returns the number of jobs that failed.
+size_t uringTransformFiles(FileTransformJob* jobs, size_t count, unsigned threads);
+
+#endif // URING_IO_H